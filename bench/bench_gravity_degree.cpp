@@ -0,0 +1,107 @@
+/*
+Spherical harmonic gravity cost vs degree
+
+Cost of one GravityField::accel call (full order) as the truncation degree grows, against the closed-form accel_j2 it
+replaces at degree 2. The recursion is O(N^2) in the degree, so ns per coefficient ((N+1)^2 of them) should stay
+roughly flat once the fixed per-call overhead is amortized. Also prints one full RK4 step through ForceModel's fused
+kernel at each degree (that adds the body-fixed rotation & 4 field evaluations).
+
+The field is synthetic (Kaula-rule magnitudes, deterministic signs), so no coefficient file is needed; the cost doesn't
+depend on the values.
+
+usage: bench_gravity_degree [n_calls]   (default 200,000)
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "Integrator.h"
+#include <astrokit/constants.h>
+#include <astrokit/force_models.h>
+#include "bench_utils.h"
+
+namespace
+{
+	constexpr int MAX_DEGREE = 120;
+
+	void write_kaula_table(const char* file_name)
+	{
+		//C/S ~ 1e-5 / n^2 with alternating signs; C20 set to Earth's so the orbits stay sensible
+		std::ofstream table(file_name);
+		table.precision(17);
+		for (int n = 2; n <= MAX_DEGREE; n++)
+		{
+			for (int m = 0; m <= n; m++)
+			{
+				double magnitude = 1e-5 / (static_cast<double>(n) * n);
+				double C = ((n + m) % 2 == 0 ? 1.0 : -1.0) * magnitude;
+				double S = (m == 0) ? 0.0 : ((n * m) % 3 == 0 ? -1.0 : 1.0) * magnitude;
+				if (n == 2 && m == 0)
+				{
+					C = -astrokit::EARTH.J2 / std::sqrt(5.0);
+				}
+				table << n << " " << m << " " << C << " " << S << "\n";
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t n_calls = (argc > 1) ? std::stoul(argv[1]) : 200000;
+
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+	const char* table = "bench_gravity_degree.tbl";
+	write_kaula_table(table);
+	earth.load_gravity_field(table, MAX_DEGREE, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_EQUATOR_km);
+	std::remove(table);
+	const GravityField& field = *earth.get_gravity_field();
+
+	Eigen::Vector<double, 6> y0;
+	y0 << 6928.0, 0.0, 0.0, 0.0, 4.5, 6.0;
+	const double dt = 10.0;
+
+	//positions swept along the orbit so every call sees a different point (no branch/cache luck from one fixed input)
+	Eigen::Vector3d sink = Eigen::Vector3d::Zero();
+	auto position = [&](std::size_t i)
+	{
+		double angle = 1e-3 * static_cast<double>(i % 6283);
+		return Eigen::Vector3d(6928.0 * std::cos(angle), 3000.0 * std::sin(angle), 6000.0 * std::sin(angle));
+	};
+
+	double ns_j2 = bench::ns_per_call(n_calls, [&](std::size_t i)
+	{
+		Eigen::Vector<double, 6> state;
+		state << position(i), Eigen::Vector3d::Zero();
+		sink += astrokit::accel_j2(state, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2).segment<3>(3);
+	});
+	std::printf("closed-form accel_j2            %9.1f ns/call\n\n", ns_j2);
+
+	std::printf("degree   accel ns/call   ns/coefficient   RK4 step ns (fused kernel)\n");
+	for (int degree : { 2, 4, 8, 16, 24, 36, 50, 70, 90, 120 })
+	{
+		double ns_field = bench::ns_per_call(n_calls, [&](std::size_t i)
+		{
+			sink += field.accel(position(i), degree, degree);
+		});
+
+		ForceModel fm(earth, false);
+		fm.set_gravity_degree(degree, degree);
+		Integrator rk4(earth, fm);
+		Eigen::Vector<double, 6> y = y0;
+		std::size_t n_steps = std::max<std::size_t>(n_calls / 4, 1);
+		double ns_step = bench::ns_per_call(n_steps, [&](std::size_t i)
+		{
+			y = rk4.step(dt * static_cast<double>(i), dt, y);
+		});
+		sink += y.segment<3>(0);
+
+		std::printf("%6d   %13.1f   %14.3f   %26.1f\n", degree, ns_field, ns_field / ((degree + 1.0) * (degree + 1.0)), ns_step);
+	}
+
+	std::printf("\n(checksum %.6g)\n", sink.sum());
+	return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+//timing helpers for the benchmark executables; not part of ctest, run them by hand from the build directory
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+namespace bench
+{
+	template <typename F>
+	double ns_per_call(std::size_t n_calls, F&& f)
+	//wall-clock nanoseconds per call of f(i) over n_calls calls; f should feed its result forward (or into a sink) so
+	// the optimizer can't drop the work
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < n_calls; i++)
+		{
+			f(i);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(n_calls);
+	}
+}
@@ -16,4 +16,198 @@ namespace astrokit
 
 		return y + (dt / 6.0) * (k1 + 2.0 * k2 + 2.0 * k3 + k4);
 	}
+
+	template <typename State>
+	struct DenseStep
+	//continuous extension of a single integration step over [t0, t0 + dt]; stored in the Hairer/Wanner form
+	// y(t0 + theta * dt) = r1 + theta * (r2 + (1 - theta) * (r3 + theta * (r4 + (1 - theta) * (r5 + theta * r6))))
+	//note: with r5 = r6 = 0 this is exactly the cubic Hermite interpolant through (y0, f0) & (y1, f1); r6 is only used
+	//      by the quintic orbit extension (orbit_hermite_dense)
+	{
+		double t0 = 0.0;
+		double dt = 0.0;
+		State r1;
+		State r2;
+		State r3;
+		State r4;
+		State r5;
+		State r6;
+
+		State evaluate(double t) const
+		{
+			const double theta = (t - t0) / dt;
+			const double theta1 = 1.0 - theta;
+			return r1 + theta * (r2 + theta1 * (r3 + theta * (r4 + theta1 * (r5 + theta * r6))));
+		}
+
+		State derivative(double t) const
+		//time derivative of the extension (chain rule through the same nesting as evaluate)
+		{
+			const double theta = (t - t0) / dt;
+			const double theta1 = 1.0 - theta;
+			const State T = r5 + theta * r6;
+			const State S = r4 + theta1 * T;
+			const State R = r3 + theta * S;
+			const State Q = r2 + theta1 * R;
+			const State dS = theta1 * r6 - T;
+			const State dR = S + theta * dS;
+			const State dQ = theta1 * dR - R;
+			return (Q + theta * dQ) / dt;
+		}
+
+		bool contains(double t) const
+		{
+			return (dt >= 0.0) ? (t >= t0 && t <= t0 + dt) : (t <= t0 && t >= t0 + dt);
+		}
+	};
+
+	template <typename State>
+	inline void hermite_dense(double t0, double dt, const State& y0, const State& f0, const State& y1, const State& f1, 
+							  DenseStep<State>& dense)
+	//cubic Hermite continuous extension from the states & derivatives at both ends of a step (any one-step method)
+	{
+		State ydiff = y1 - y0;
+		State bspl = dt * f0 - ydiff;
+
+		dense.t0 = t0;
+		dense.dt = dt;
+		dense.r1 = y0;
+		dense.r2 = ydiff;
+		dense.r3 = bspl;
+		dense.r4 = ydiff - dt * f1 - bspl;
+		dense.r5 = 0.0 * ydiff;
+		dense.r6 = 0.0 * ydiff;
+	}
+
+	template <typename State>
+	inline void orbit_hermite_dense(double t0, double dt, const State& y0, const State& f0, const State& y1, const State& f1, 
+									DenseStep<State>& dense)
+	//quintic Hermite continuous extension for orbit states y = [r; v] with f = [v; a]. the accelerations at both ends are
+	// the positions' second derivatives, so the position gets a quintic through (r, v, a) at both ends (error ~ dt^6
+	// instead of the cubic's dt^4) at no extra cost, and the velocity is its exact derivative (a quartic through the
+	// same end velocities & accelerations)
+	//note: State is a 6-vector (position then velocity)
+	{
+		hermite_dense(t0, dt, y0, f0, y1, f1, dense);
+
+		//position: r5 & r6 match the second derivatives dt^2 * a at theta = 0 & 1
+		auto r3 = dense.r3.template head<3>();
+		auto r4 = dense.r4.template head<3>();
+		auto r5 = dense.r5.template head<3>();
+		auto r6 = dense.r6.template head<3>();
+		r5 = 0.5 * dt * dt * f0.template tail<3>() + r3 - r4;
+		r6 = 0.5 * dt * dt * f1.template tail<3>() + r3 + 2.0 * r4 - r5;
+
+		//velocity: the cubic Hermite part already matches v & dt * a at both ends; r5 adds the position quintic's third
+		// derivative at theta = 0 (-6 r4 - 12 r5 + 6 r6, scaled by 1/dt) so it's exactly the derivative of the position
+		dense.r5.template tail<3>() = (-3.0 * r4 - 6.0 * r5 + 3.0 * r6) / dt + dense.r3.template tail<3>() - dense.r4.template tail<3>();
+	}
+
+	template <typename State, typename F>
+	inline State rk4_dense_step(double t, double dt, const State& y, const State& k1, const F& f, State& f_new, 
+								DenseStep<State>& dense)
+	//rk4_step with a Hermite continuous extension; k1 = f(t, y) is passed in and f_new = f(t + dt, y_new) is handed back
+	// so consecutive steps reuse it (4 evaluations per step, same as plain rk4_step)
+	{
+		State k2 = f(t + 0.5 * dt, y + 0.5 * dt * k1);
+		State k3 = f(t + 0.5 * dt, y + 0.5 * dt * k2);
+		State k4 = f(t + dt, y + dt * k3);
+
+		State y_new = y + (dt / 6.0) * (k1 + 2.0 * k2 + 2.0 * k3 + k4);
+		f_new = f(t + dt, y_new);
+
+		hermite_dense(t, dt, y, k1, y_new, f_new, dense);
+		return y_new;
+	}
+
+	template <typename State, typename F>
+	inline State dopri54_step(double t, double dt, const State& y, const State& k1, const F& f, State& y_err, State& f_new, 
+							  DenseStep<State>& dense)
+	//Dormand-Prince 5(4) embedded pair; returns the 5th order solution and fills y_err with the difference
+	// between the 5th and 4th order solutions (local error estimate for step size control)
+	//k1 = f(t, y) is passed in; f_new = f(t + dt, y_new) comes back out (first-same-as-last, so 6 evaluations per step)
+	//dense holds the built-in 4th order continuous extension of the step
+	//note: same State/f requirements as rk4_step
+	{
+		State k2 = f(t + dt / 5.0, y + dt * (k1 / 5.0));
+		State k3 = f(t + 3.0 * dt / 10.0, y + dt * (3.0 / 40.0 * k1 + 9.0 / 40.0 * k2));
+		State k4 = f(t + 4.0 * dt / 5.0, y + dt * (44.0 / 45.0 * k1 - 56.0 / 15.0 * k2 + 32.0 / 9.0 * k3));
+		State k5 = f(t + 8.0 * dt / 9.0, y + dt * (19372.0 / 6561.0 * k1 - 25360.0 / 2187.0 * k2 + 64448.0 / 6561.0 * k3 
+												   - 212.0 / 729.0 * k4));
+		State k6 = f(t + dt, y + dt * (9017.0 / 3168.0 * k1 - 355.0 / 33.0 * k2 + 46732.0 / 5247.0 * k3 + 49.0 / 176.0 * k4 
+									   - 5103.0 / 18656.0 * k5));
+
+		State y_new = y + dt * (35.0 / 384.0 * k1 + 500.0 / 1113.0 * k3 + 125.0 / 192.0 * k4 - 2187.0 / 6784.0 * k5 
+								+ 11.0 / 84.0 * k6);
+		State k7 = f(t + dt, y_new);
+
+		y_err = dt * (71.0 / 57600.0 * k1 - 71.0 / 16695.0 * k3 + 71.0 / 1920.0 * k4 - 17253.0 / 339200.0 * k5 
+					  + 22.0 / 525.0 * k6 - 1.0 / 40.0 * k7);
+		f_new = k7;
+
+		//continuous extension (Hairer, Norsett & Wanner's dopri5 coefficients)
+		State ydiff = y_new - y;
+		State bspl = dt * k1 - ydiff;
+		dense.t0 = t;
+		dense.dt = dt;
+		dense.r1 = y;
+		dense.r2 = ydiff;
+		dense.r3 = bspl;
+		dense.r4 = ydiff - dt * k7 - bspl;
+		dense.r5 = dt * (-12715105075.0 / 11282082432.0 * k1 + 87487479700.0 / 32700410799.0 * k3 
+						 - 10690763975.0 / 1880347072.0 * k4 + 701980252875.0 / 199316789632.0 * k5 
+						 - 1453857185.0 / 822651844.0 * k6 + 69997945.0 / 29380423.0 * k7);
+		dense.r6 = 0.0 * ydiff;
+
+		return y_new;
+	}
+
+	template <typename State, typename F>
+	inline State dopri54_step(double t, double dt, const State& y, const F& f, State& y_err)
+	//convenience version of the above when no dense output or derivative reuse is needed
+	{
+		State f_new;
+		DenseStep<State> dense;
+		return dopri54_step(t, dt, y, f(t, y), f, y_err, f_new, dense);
+	}
+
+	template <typename State, typename F>
+	inline State rkf78_step(double t, double dt, const State& y, const State& k1, const F& f, State& y_err)
+	//Runge-Kutta-Fehlberg 7(8) embedded pair (13 stages); returns the 8th order solution and fills y_err with the
+	// difference between the 8th and 7th order solutions. k1 = f(t, y) is passed in.
+	//note: same State/f requirements as rk4_step
+	{
+		State k2 = f(t + 2.0 / 27.0 * dt, y + dt * (2.0 / 27.0 * k1));
+		State k3 = f(t + 1.0 / 9.0 * dt, y + dt * (1.0 / 36.0 * k1 + 1.0 / 12.0 * k2));
+		State k4 = f(t + 1.0 / 6.0 * dt, y + dt * (1.0 / 24.0 * k1 + 1.0 / 8.0 * k3));
+		State k5 = f(t + 5.0 / 12.0 * dt, y + dt * (5.0 / 12.0 * k1 - 25.0 / 16.0 * k3 + 25.0 / 16.0 * k4));
+		State k6 = f(t + 1.0 / 2.0 * dt, y + dt * (1.0 / 20.0 * k1 + 1.0 / 4.0 * k4 + 1.0 / 5.0 * k5));
+		State k7 = f(t + 5.0 / 6.0 * dt, y + dt * (-25.0 / 108.0 * k1 + 125.0 / 108.0 * k4 - 65.0 / 27.0 * k5 
+												   + 125.0 / 54.0 * k6));
+		State k8 = f(t + 1.0 / 6.0 * dt, y + dt * (31.0 / 300.0 * k1 + 61.0 / 225.0 * k5 - 2.0 / 9.0 * k6 
+												   + 13.0 / 900.0 * k7));
+		State k9 = f(t + 2.0 / 3.0 * dt, y + dt * (2.0 * k1 - 53.0 / 6.0 * k4 + 704.0 / 45.0 * k5 - 107.0 / 9.0 * k6 
+												   + 67.0 / 90.0 * k7 + 3.0 * k8));
+		State k10 = f(t + 1.0 / 3.0 * dt, y + dt * (-91.0 / 108.0 * k1 + 23.0 / 108.0 * k4 - 976.0 / 135.0 * k5 
+													+ 311.0 / 54.0 * k6 - 19.0 / 60.0 * k7 + 17.0 / 6.0 * k8 - 1.0 / 12.0 * k9));
+		State k11 = f(t + dt, y + dt * (2383.0 / 4100.0 * k1 - 341.0 / 164.0 * k4 + 4496.0 / 1025.0 * k5 - 301.0 / 82.0 * k6 
+										+ 2133.0 / 4100.0 * k7 + 45.0 / 82.0 * k8 + 45.0 / 164.0 * k9 + 18.0 / 41.0 * k10));
+		State k12 = f(t, y + dt * (3.0 / 205.0 * k1 - 6.0 / 41.0 * k6 - 3.0 / 205.0 * k7 - 3.0 / 41.0 * k8 + 3.0 / 41.0 * k9 
+								   + 6.0 / 41.0 * k10));
+		State k13 = f(t + dt, y + dt * (-1777.0 / 4100.0 * k1 - 341.0 / 164.0 * k4 + 4496.0 / 1025.0 * k5 - 289.0 / 82.0 * k6 
+										+ 2193.0 / 4100.0 * k7 + 51.0 / 82.0 * k8 + 33.0 / 164.0 * k9 + 12.0 / 41.0 * k10 + k12));
+
+		State y_new = y + dt * (34.0 / 105.0 * k6 + 9.0 / 35.0 * k7 + 9.0 / 35.0 * k8 + 9.0 / 280.0 * k9 + 9.0 / 280.0 * k10 
+								+ 41.0 / 840.0 * k12 + 41.0 / 840.0 * k13);
+
+		y_err = dt * (41.0 / 840.0 * (k1 + k11 - k12 - k13));
+
+		return y_new;
+	}
+
+	template <typename State, typename F>
+	inline State rkf78_step(double t, double dt, const State& y, const F& f, State& y_err)
+	{
+		return rkf78_step(t, dt, y, f(t, y), f, y_err);
+	}
 } // namespace astrokit
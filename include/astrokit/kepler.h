@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cmath>
+#include <stdexcept>
+#include <Eigen/Dense>
+#include "constants.h"
+
+namespace astrokit
+{
+	inline double wrap_2pi(double angle)
+	//wraps an angle into [0, 2pi)
+	{
+		angle = std::fmod(angle, 2.0 * PI);
+		return (angle < 0.0) ? angle + 2.0 * PI : angle;
+	}
+
+	inline double wrap_pi(double angle)
+	//wraps an angle into [-pi, pi); for differences between angles
+	{
+		angle = wrap_2pi(angle + PI);
+		return angle - PI;
+	}
+
+	inline double solve_kepler(double M, double e, double tol = 1e-14, int max_iter = 50)
+	//eccentric anomaly from mean anomaly (elliptic orbits); Newton's method on E - e * sin(E) = M
+	{
+		if (e < 0.0 || e >= 1.0)
+		{
+			throw std::runtime_error("solve_kepler only handles elliptic orbits (0 <= e < 1).");
+		}
+		M = wrap_2pi(M);
+		double E = (e < 0.8) ? M : PI; //standard starting guesses; PI keeps Newton stable for high eccentricity
+		for (int i = 0; i < max_iter; i++)
+		{
+			double dE = (E - e * std::sin(E) - M) / (1.0 - e * std::cos(E));
+			E -= dE;
+			if (std::abs(dE) < tol)
+			{
+				break;
+			}
+		}
+		return E;
+	}
+
+	inline double eccentric_to_true_anomaly(double E, double e)
+	{
+		return wrap_2pi(2.0 * std::atan2(std::sqrt(1.0 + e) * std::sin(0.5 * E), std::sqrt(1.0 - e) * std::cos(0.5 * E)));
+	}
+
+	inline double true_to_mean_anomaly(double ta, double e)
+	{
+		double E = 2.0 * std::atan2(std::sqrt(1.0 - e) * std::sin(0.5 * ta), std::sqrt(1.0 + e) * std::cos(0.5 * ta));
+		return wrap_2pi(E - e * std::sin(E));
+	}
+
+	inline double mean_to_true_anomaly(double M, double e)
+	{
+		return eccentric_to_true_anomaly(solve_kepler(M, e), e);
+	}
+
+	inline Eigen::Vector3d j2_secular_rates(double a, double e, double i, double mu, double Re, double J2)
+	//first-order secular drift of the node, argument of periapsis & mean anomaly under J2
+	//return order: raan_dot, argp_dot, M_dot [rad/s]; M_dot includes the mean motion
+	{
+		double n = std::sqrt(mu / (a * a * a));
+		double p = a * (1.0 - e * e);
+		double k = n * J2 * (Re / p) * (Re / p);
+		double ci = std::cos(i);
+
+		double raan_dot = -1.5 * k * ci;
+		double argp_dot = 0.75 * k * (5.0 * ci * ci - 1.0);
+		double M_dot = n + 0.75 * k * std::sqrt(1.0 - e * e) * (3.0 * ci * ci - 1.0);
+
+		return Eigen::Vector3d(raan_dot, argp_dot, M_dot);
+	}
+
+	inline Eigen::Vector<double, 6> j2_secular_coes(const Eigen::Vector<double, 6>& coes0, double dt, double mu, double Re, double J2)
+	//mean elements dt seconds after coes0 with only the J2 secular rates applied (sma, ecc & inc stay fixed)
+	//same element order as cart_to_coe (sma, ecc, inc, raan, argp, ta); J2 = 0 gives plain two-body motion
+	//note: for repeated evaluation from the same epoch, precompute the rates & M0 and skip straight to the last few lines
+	{
+		Eigen::Vector3d rates = j2_secular_rates(coes0[0], coes0[1], coes0[2], mu, Re, J2);
+		double M0 = true_to_mean_anomaly(coes0[5], coes0[1]);
+
+		Eigen::Vector<double, 6> coes = coes0;
+		coes[3] = wrap_2pi(coes0[3] + rates[0] * dt);
+		coes[4] = wrap_2pi(coes0[4] + rates[1] * dt);
+		coes[5] = mean_to_true_anomaly(M0 + rates[2] * dt, coes0[1]);
+		return coes;
+	}
+
+	inline void stumpff(double z, double& C, double& S)
+	//Stumpff functions C(z) & S(z) for the universal-variable formulation; series near z = 0 to avoid cancellation
+	{
+		if (z > 1e-3)
+		{
+			double sz = std::sqrt(z);
+			C = (1.0 - std::cos(sz)) / z;
+			S = (sz - std::sin(sz)) / (sz * z);
+		}
+		else if (z < -1e-3)
+		{
+			double sz = std::sqrt(-z);
+			C = (std::cosh(sz) - 1.0) / (-z);
+			S = (std::sinh(sz) - sz) / (sz * -z);
+		}
+		else
+		{
+			C = 1.0 / 2.0 - z * (1.0 / 24.0 - z * (1.0 / 720.0 - z / 40320.0));
+			S = 1.0 / 6.0 - z * (1.0 / 120.0 - z * (1.0 / 5040.0 - z / 362880.0));
+		}
+	}
+
+	class UniversalKepler
+	{
+	public:
+		//closed-form two-body propagation from one epoch state with the universal variable (any conic)
+		//note: everything that only depends on the epoch state is computed once here, so evaluating the same orbit at many
+		//      epochs only costs the Newton solve + Lagrange coefficients per sample
+		UniversalKepler(const Eigen::Vector<double, 6>& state0, double mu) :
+			r0(state0.segment<3>(0)), v0(state0.segment<3>(3)), mu(mu)
+		{
+			this->sqrt_mu = std::sqrt(mu);
+			this->r0_norm = this->r0.norm();
+			this->sigma0 = this->r0.dot(this->v0) / this->sqrt_mu;
+			this->alpha = 2.0 / this->r0_norm - this->v0.squaredNorm() / mu; //1 / sma; negative for hyperbolic orbits
+			//bound orbits repeat every period, so only the remainder of dt has to be solved for (keeps chi small over long spans)
+			this->period = (this->alpha > 0.0) ? 2.0 * PI / (this->sqrt_mu * std::pow(this->alpha, 1.5)) : 0.0;
+		}
+
+		Eigen::Vector<double, 6> state_at(double dt) const
+		{
+			double chi = initial_guess(dt);
+			return state_at(dt, chi);
+		}
+
+		Eigen::Vector<double, 6> state_at(double dt, double& chi, double tol = 1e-12, int max_iter = 50) const
+		//chi is the starting guess on input & the converged universal anomaly (for the reduced dt) on output
+		{
+			if (this->period > 0.0)
+			{
+				dt = std::fmod(dt, this->period);
+			}
+
+			//Newton iterations on the universal Kepler equation
+			double C = 0.5, S = 1.0 / 6.0, r = this->r0_norm;
+			for (int i = 0; i < max_iter; i++)
+			{
+				double chi2 = chi * chi;
+				stumpff(this->alpha * chi2, C, S);
+				double F = this->sigma0 * chi2 * C + (1.0 - this->alpha * this->r0_norm) * chi2 * chi * S + this->r0_norm * chi - this->sqrt_mu * dt;
+				r = this->sigma0 * chi * (1.0 - this->alpha * chi2 * S) + (1.0 - this->alpha * this->r0_norm) * chi2 * C + this->r0_norm; //dF/dchi = |r|
+				double dchi = F / r;
+				chi -= dchi;
+				if (std::abs(dchi) <= tol * std::max(1.0, std::abs(chi)))
+				{
+					break; //note: C & S from just before the (negligible) last correction are reused below
+				}
+			}
+
+			//Lagrange coefficients
+			double chi2 = chi * chi;
+			double f = 1.0 - chi2 / this->r0_norm * C;
+			double g = dt - chi2 * chi / this->sqrt_mu * S;
+			Eigen::Vector3d r_vec = f * this->r0 + g * this->v0;
+			double r_norm = r_vec.norm();
+			double f_dot = this->sqrt_mu / (r_norm * this->r0_norm) * (this->alpha * chi2 * chi * S - chi);
+			double g_dot = 1.0 - chi2 / r_norm * C;
+
+			Eigen::Vector<double, 6> state;
+			state << r_vec, f_dot * this->r0 + g_dot * this->v0;
+			return state;
+		}
+
+		void states_at(const double* dts, std::size_t n, Eigen::Vector<double, 6>* states) const
+		//batch evaluation over n epochs (dts ascending); each solve is warm-started from the previous one (dchi/dt = sqrt(mu) / |r|)
+		{
+			double chi = 0.0, prev_dt = 0.0, prev_r = this->r0_norm;
+			for (std::size_t k = 0; k < n; k++)
+			{
+				double dt = (this->period > 0.0) ? std::fmod(dts[k], this->period) : dts[k];
+				//the first sample & every wrap into a new period start over from the plain guess
+				chi = (k == 0 || dt < prev_dt) ? initial_guess(dt) : chi + this->sqrt_mu / prev_r * (dt - prev_dt);
+				states[k] = state_at(dt, chi);
+				prev_dt = dt;
+				prev_r = states[k].segment<3>(0).norm();
+			}
+		}
+
+		double initial_guess(double dt) const
+		{
+			if (this->period > 0.0)
+			{
+				return this->sqrt_mu * this->alpha * std::fmod(dt, this->period);
+			}
+			if (this->alpha < 0.0 && dt != 0.0)
+			{
+				//hyperbolic starting guess (Vallado, Algorithm 8)
+				double a = 1.0 / this->alpha;
+				double sgn = (dt > 0.0) ? 1.0 : -1.0;
+				double arg = -2.0 * this->mu * this->alpha * dt /
+							 (this->sigma0 * this->sqrt_mu + sgn * std::sqrt(-this->mu * a) * (1.0 - this->r0_norm * this->alpha));
+				if (arg > 0.0)
+				{
+					return sgn * std::sqrt(-a) * std::log(arg);
+				}
+			}
+			return this->sqrt_mu * dt / this->r0_norm; //near-parabolic; Newton takes it from here
+		}
+
+		double get_period() const { return this->period; } //0 for unbound orbits
+
+	private:
+		Eigen::Vector3d r0;
+		Eigen::Vector3d v0;
+		double mu;
+		double sqrt_mu;
+		double r0_norm;
+		double sigma0; //r0 . v0 / sqrt(mu)
+		double alpha;
+		double period;
+	};
+
+	inline Eigen::Vector<double, 6> propagate_kepler(const Eigen::Vector<double, 6>& state0, double dt, double mu)
+	//one-off closed-form two-body propagation; use UniversalKepler directly when sampling the same orbit repeatedly
+	{
+		return UniversalKepler(state0, mu).state_at(dt);
+	}
+
+} // namespace astrokit
@@ -3,6 +3,7 @@
 #include <cmath>
 #include <algorithm>
 #include <random>
+#include <limits>
 #include <Eigen/Dense>
 #include "constants.h"
 
@@ -47,6 +48,105 @@ namespace astrokit
 		return angle;
 	}
 
+	template <typename F>
+	inline double find_root(const F& f, double a, double b, double fa, double fb, double tol, int max_iter = 100)
+	//Brent's method for a root of f in [a, b]; fa = f(a) & fb = f(b) must have opposite signs (or one of them be zero)
+	//combines bisection with secant/inverse quadratic steps, so it converges superlinearly on smooth functions but never
+	// does worse than bisection. stops once the bracket is within tol
+	{
+		if (fa == 0.0)
+		{
+			return a;
+		}
+		if (fb == 0.0)
+		{
+			return b;
+		}
+
+		double c = a;
+		double fc = fa;
+		double d = b - a;
+		double e = d;
+		for (int i = 0; i < max_iter; i++)
+		{
+			if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0))
+			{
+				//keep the root bracketed between b & c
+				c = a;
+				fc = fa;
+				d = b - a;
+				e = d;
+			}
+			if (std::abs(fc) < std::abs(fb))
+			{
+				//b is always the best estimate so far
+				a = b;
+				b = c;
+				c = a;
+				fa = fb;
+				fb = fc;
+				fc = fa;
+			}
+
+			double tol1 = 2.0 * std::numeric_limits<double>::epsilon() * std::abs(b) + 0.5 * tol;
+			double m = 0.5 * (c - b);
+			if (std::abs(m) <= tol1 || fb == 0.0)
+			{
+				return b;
+			}
+
+			if (std::abs(e) >= tol1 && std::abs(fa) > std::abs(fb))
+			{
+				//try interpolating (secant if only two distinct points, inverse quadratic otherwise)
+				double s = fb / fa;
+				double p;
+				double q;
+				if (a == c)
+				{
+					p = 2.0 * m * s;
+					q = 1.0 - s;
+				}
+				else
+				{
+					double r = fb / fc;
+					q = fa / fc;
+					p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+					q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+				}
+				if (p > 0.0)
+				{
+					q = -q;
+				}
+				else
+				{
+					p = -p;
+				}
+
+				if (2.0 * p < std::min(3.0 * m * q - std::abs(tol1 * q), std::abs(e * q)))
+				{
+					e = d;
+					d = p / q;
+				}
+				else
+				{
+					d = m; //interpolation is misbehaving; fall back to bisection
+					e = d;
+				}
+			}
+			else
+			{
+				d = m;
+				e = d;
+			}
+
+			a = b;
+			fa = fb;
+			b += (std::abs(d) > tol1) ? d : ((m > 0.0) ? tol1 : -tol1);
+			fb = f(b);
+		}
+		return b;
+	}
+
 	inline int random_int(int min, int max)
 	//using a uniform distribution for these
 	{
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "AccessAnalyzer.h"
+#include <astrokit/math_utils.h>
+#include <astrokit/integrators.h>
+
+AccessAnalyzer::AccessAnalyzer(Planet& cb) : cb(cb), time_tol(1e-3)
+{
+}
+
+AccessAnalyzer::AccessAnalyzer(Planet& cb, double time_tol) : cb(cb)
+{
+	set_time_tol(time_tol);
+}
+
+#pragma region getters
+double AccessAnalyzer::get_time_tol() const
+{
+	return this->time_tol;
+}
+#pragma endregion getters
+
+#pragma region setters
+void AccessAnalyzer::set_time_tol(double new_time_tol)
+{
+	if (new_time_tol <= 0.0)
+	{
+		throw std::runtime_error("Access time tolerance must be positive.");
+	}
+	this->time_tol = new_time_tol;
+}
+#pragma endregion setters
+
+#pragma region utilities
+std::vector<AccessInterval> AccessAnalyzer::compute_access(const std::vector<Spacecraft>& sats)
+{
+	ThreadPool serial(1);
+	return compute_access(sats, serial);
+}
+
+std::vector<AccessInterval> AccessAnalyzer::compute_access(const std::vector<Spacecraft>& sats, ThreadPool& pool)
+{
+	//all of the SPICE work happens here, serially, before anything runs in parallel
+	//note: constellation members are propagated in lockstep, so normally there's only one grid for everyone
+	std::vector<EpochGrid> grids;
+	std::vector<std::size_t> sc_grid(sats.size());
+	for (std::size_t i = 0; i < sats.size(); i++)
+	{
+		sc_grid[i] = find_or_add_grid(sats[i].get_et_history(), grids);
+	}
+
+	std::vector<std::vector<AccessInterval>> per_sc(sats.size());
+	pool.parallel_for(sats.size(), [&](std::size_t i0, std::size_t i1)
+	{
+		for (std::size_t i = i0; i < i1; i++)
+		{
+			access_for_spacecraft(sats[i], i, grids[sc_grid[i]], per_sc[i]);
+		}
+	});
+
+	std::vector<AccessInterval> intervals;
+	for (const auto& sc_intervals : per_sc)
+	{
+		intervals.insert(intervals.end(), sc_intervals.begin(), sc_intervals.end());
+	}
+	return intervals;
+}
+
+std::size_t AccessAnalyzer::find_or_add_grid(HistoryArena::ConstColumn et, std::vector<EpochGrid>& grids)
+{
+	for (std::size_t g = 0; g < grids.size(); g++)
+	{
+		if (grids[g].et.size() == static_cast<std::size_t>(et.size()) && std::equal(et.begin(), et.end(), grids[g].et.begin()))
+		{
+			return g;
+		}
+	}
+
+	EpochGrid grid;
+	grid.et.assign(et.begin(), et.end());
+	grid.icrf_R_bcf = this->cb.icrf_R_bcf(grid.et); //served from the planet's rotation cache when there is one
+	grid.q_icrf_R_bcf.reserve(grid.et.size());
+	for (const auto& R : grid.icrf_R_bcf)
+	{
+		grid.q_icrf_R_bcf.push_back(Eigen::Quaterniond(R));
+	}
+	grids.push_back(std::move(grid));
+	return grids.size() - 1;
+}
+
+void AccessAnalyzer::access_for_spacecraft(const Spacecraft& sc, std::size_t sc_index, const EpochGrid& grid,
+										   std::vector<AccessInterval>& intervals) const
+{
+	const std::vector<GroundStation>& stations = this->cb.get_stations();
+	HistoryArena::ConstBlock cart = sc.get_cartesian_history();
+	const std::size_t n = grid.et.size();
+	if (n == 0 || stations.empty())
+	{
+		return;
+	}
+
+	//body-fixed positions for every output step (3 x n)
+	Eigen::Matrix3Xd r_bcf(3, n);
+	for (std::size_t k = 0; k < n; k++)
+	{
+		r_bcf.col(k) = grid.icrf_R_bcf[k] * cart.row(k).head<3>().transpose();
+	}
+
+	const double radius = this->cb.get_mean_radius();
+	for (std::size_t j = 0; j < stations.size(); j++)
+	{
+		const Eigen::Vector3d normal = stations[j].get_surface_normal_bcf();
+		const Eigen::Vector3d site = radius * normal;
+		const double sin_mask = std::sin(stations[j].get_elevation_mask());
+
+		//sin(elevation) - sin(mask) has the same sign as elevation - mask, and needs no asin per sample
+		Eigen::Matrix3Xd los = r_bcf.colwise() - site;
+		Eigen::ArrayXd f = (normal.transpose() * los).transpose().array() / los.colwise().norm().transpose().array() - sin_mask;
+
+		//elevation margin at any time inside [k, k + 1], from the interpolated state & rotation
+		auto margin_between = [&](std::size_t k)
+		{
+			const double t0 = grid.et[k];
+			const double dt = grid.et[k + 1] - t0;
+			astrokit::DenseStep<Eigen::Vector3d> pos;
+			astrokit::hermite_dense<Eigen::Vector3d>(t0, dt, cart.row(k).head<3>().transpose(), cart.row(k).tail<3>().transpose(),
+													 cart.row(k + 1).head<3>().transpose(), cart.row(k + 1).tail<3>().transpose(), pos);
+			const Eigen::Quaterniond q0 = grid.q_icrf_R_bcf[k];
+			const Eigen::Quaterniond q1 = grid.q_icrf_R_bcf[k + 1];
+			return [=](double t)
+			{
+				Eigen::Vector3d d = q0.slerp((t - t0) / dt, q1) * pos.evaluate(t) - site;
+				return normal.dot(d) / d.norm() - sin_mask;
+			};
+		};
+		auto refine = [&](std::size_t k)
+		{
+			if (grid.et[k + 1] == grid.et[k]) //zero-length step (e.g. a burn logged as its own row)
+			{
+				return grid.et[k];
+			}
+			auto g = margin_between(k);
+			return astrokit::find_root(g, grid.et[k], grid.et[k + 1], f[k], f[k + 1], this->time_tol);
+		};
+
+		bool in_pass = f[0] >= 0.0;
+		AccessInterval pass{ sc_index, j, grid.et[0], grid.et[0], std::asin(std::clamp(f[0] + sin_mask, -1.0, 1.0)) };
+		for (std::size_t k = 1; k < n; k++)
+		{
+			if (!in_pass && f[k] >= 0.0)
+			{
+				in_pass = true;
+				pass.rise_et = refine(k - 1);
+				pass.max_elevation = -astrokit::PI;
+			}
+			else if (in_pass && f[k] < 0.0)
+			{
+				in_pass = false;
+				pass.set_et = refine(k - 1);
+				intervals.push_back(pass);
+			}
+			if (in_pass)
+			{
+				pass.max_elevation = std::max(pass.max_elevation, std::asin(std::clamp(f[k] + sin_mask, -1.0, 1.0)));
+			}
+		}
+		if (in_pass) //still in view at the end of the history
+		{
+			pass.set_et = grid.et[n - 1];
+			intervals.push_back(pass);
+		}
+	}
+}
+#pragma endregion utilities
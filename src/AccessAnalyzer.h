@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+#include "structure_definitions.h"
+#include "Planet.h"
+#include "Spacecraft.h"
+#include "ThreadPool.h"
+
+class AccessAnalyzer
+{
+public:
+	//ground station access (AOS/LOS) from the propagated histories
+	//elevation is evaluated for every output step of every spacecraft x station pair in one pass per spacecraft (positions
+	// rotated to the body-fixed frame once, then all stations at once with Eigen array math). sign changes of
+	// (elevation - mask) bracket the rise/set times, which get refined with Brent's method on a cubic Hermite interpolant
+	// of the position (the history has velocities) and a slerp of the body rotation between the bracketing steps
+	//note: the body rotation is looked up once per distinct history epoch (from Planet's rotation cache when it has one) and
+	//      is shared by every spacecraft on the same output grid; nothing calls SPICE per sample or during refinement
+	//      (SPICE isn't thread-safe, so any lookups stay up front)
+	//note: a pass that starts & ends between two output steps can't be bracketed; keep the output step well below the
+	//      shortest pass you care about
+	//note: spherical body (mean radius) for the station positions, matching GroundStation::compute_surface_normal
+	AccessAnalyzer(Planet& cb);
+	AccessAnalyzer(Planet& cb, double time_tol);
+
+	//getters
+	double get_time_tol() const;
+
+	//setters
+	void set_time_tol(double new_time_tol);
+
+	//utilities
+	std::vector<AccessInterval> compute_access(const std::vector<Spacecraft>& sats);
+	std::vector<AccessInterval> compute_access(const std::vector<Spacecraft>& sats, ThreadPool& pool);
+	//note: every spacecraft against every station on the central body; intervals are ordered by spacecraft, then station,
+	//      then rise time. the pool splits the spacecraft across threads (results don't depend on the thread count)
+
+private:
+	struct EpochGrid //body rotations for one set of history epochs
+	{
+		std::vector<double> et;
+		std::vector<Eigen::Matrix3d> icrf_R_bcf;
+		std::vector<Eigen::Quaterniond> q_icrf_R_bcf; //same rotations; used for slerp during refinement
+	};
+
+	std::size_t find_or_add_grid(HistoryArena::ConstColumn et, std::vector<EpochGrid>& grids);
+	void access_for_spacecraft(const Spacecraft& sc, std::size_t sc_index, const EpochGrid& grid,
+							   std::vector<AccessInterval>& intervals) const;
+
+	Planet& cb;
+	double time_tol; //[s]; rise/set times are refined to within this
+};
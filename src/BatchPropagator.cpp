@@ -0,0 +1,161 @@
+#include <algorithm>
+#include "BatchPropagator.h"
+#include "simd_utils.h"
+
+namespace
+{
+	//keplerian + J2 acceleration for one SIMD block of satellites
+	//note: follows the same operation order as astrokit::accel_kep & astrokit::accel_j2
+	inline void gravity(const simd::vec& x, const simd::vec& y, const simd::vec& z,
+		simd::vec& ax, simd::vec& ay, simd::vec& az,
+		double mu, double eq_radius, double j2, bool include_j2)
+	{
+		const simd::vec R = simd::sqrt(x * x + y * y + z * z);
+		const simd::vec R3 = R * R * R;
+		const simd::vec neg_mu = simd::broadcast(-mu);
+
+		ax = (neg_mu * x) / R3;
+		ay = (neg_mu * y) / R3;
+		az = (neg_mu * z) / R3;
+
+		if (include_j2)
+		{
+			const simd::vec R2 = R * R;
+			const simd::vec R5 = R2 * R2 * R;
+			const simd::vec factor = simd::broadcast(1.5 * j2 * mu * eq_radius * eq_radius) / R5;
+			const simd::vec k = simd::broadcast(5.0) * (z * z) / R2;
+			const simd::vec one = simd::broadcast(1.0);
+			const simd::vec three = simd::broadcast(3.0);
+
+			ax = ax + x * (k - one) * factor;
+			ay = ay + y * (k - one) * factor;
+			az = az + z * (k - three) * factor;
+		}
+	}
+}
+
+BatchPropagator::BatchPropagator(double mu, double eq_radius, double j2, bool include_j2) :
+	mu(mu), eq_radius(eq_radius), j2(j2), include_j2(include_j2), count(0)
+{
+}
+
+BatchPropagator::BatchPropagator(const ForceModel& fm) :
+	mu(fm.get_cb().get_mu()), eq_radius(fm.get_cb().get_eq_radius()), j2(fm.get_cb().get_j2()),
+	include_j2(fm.get_include_j2()), count(0)
+{
+}
+
+#pragma region getters
+std::size_t BatchPropagator::get_count() const
+{
+	return this->count;
+}
+
+Eigen::Vector<double, 6> BatchPropagator::get_state(std::size_t i) const
+{
+	Eigen::Vector<double, 6> state;
+	state << this->x[i], this->y[i], this->z[i], this->vx[i], this->vy[i], this->vz[i];
+
+	return state;
+}
+#pragma endregion getters
+
+#pragma region setters
+void BatchPropagator::set_state(std::size_t i, const Eigen::Vector<double, 6>& state)
+{
+	this->x[i] = state[0];
+	this->y[i] = state[1];
+	this->z[i] = state[2];
+	this->vx[i] = state[3];
+	this->vy[i] = state[4];
+	this->vz[i] = state[5];
+}
+#pragma endregion setters
+
+#pragma region utilities
+void BatchPropagator::load_states(const std::vector<Eigen::Vector<double, 6>>& states)
+{
+	this->count = states.size();
+	std::size_t n_lanes = simd::padded_size(this->count);
+
+	this->x.assign(n_lanes, 0.0);
+	this->y.assign(n_lanes, 0.0);
+	this->z.assign(n_lanes, 0.0);
+	this->vx.assign(n_lanes, 0.0);
+	this->vy.assign(n_lanes, 0.0);
+	this->vz.assign(n_lanes, 0.0);
+
+	for (std::size_t i = 0; i < n_lanes; i++)
+	{
+		//note: padding lanes just repeat the last real satellite so they stay on a physical orbit (no divide-by-zero
+		//      or denormal slowdowns); their results are never read back
+		if (this->count > 0)
+		{
+			set_state(i, states[std::min(i, this->count - 1)]);
+		}
+	}
+}
+
+void BatchPropagator::step(double t, double dt)
+{
+	step(t, dt, 0, this->x.size());
+}
+
+void BatchPropagator::step(double, double dt, std::size_t lane0, std::size_t lanef)
+//fixed-step RK4 over lanes [lane0, lanef); lane0 should sit on a SIMD block boundary
+//note: each block of satellites is carried through all four stages in registers so no stage scratch arrays are needed
+{
+	lanef = std::min(lanef, this->x.size());
+
+	const simd::vec half_dt = simd::broadcast(0.5 * dt);
+	const simd::vec full_dt = simd::broadcast(dt);
+	const simd::vec sixth_dt = simd::broadcast(dt / 6.0);
+	const simd::vec two = simd::broadcast(2.0);
+
+	for (std::size_t i = lane0; i < lanef; i += simd::WIDTH)
+	{
+		const simd::vec rx = simd::load(&this->x[i]);
+		const simd::vec ry = simd::load(&this->y[i]);
+		const simd::vec rz = simd::load(&this->z[i]);
+		const simd::vec ux = simd::load(&this->vx[i]);
+		const simd::vec uy = simd::load(&this->vy[i]);
+		const simd::vec uz = simd::load(&this->vz[i]);
+
+		//k1
+		simd::vec a1x, a1y, a1z;
+		gravity(rx, ry, rz, a1x, a1y, a1z, this->mu, this->eq_radius, this->j2, this->include_j2);
+
+		//k2; evaluated at y + 0.5 * dt * k1
+		const simd::vec v2x = ux + half_dt * a1x;
+		const simd::vec v2y = uy + half_dt * a1y;
+		const simd::vec v2z = uz + half_dt * a1z;
+		simd::vec a2x, a2y, a2z;
+		gravity(rx + half_dt * ux, ry + half_dt * uy, rz + half_dt * uz, a2x, a2y, a2z,
+			    this->mu, this->eq_radius, this->j2, this->include_j2);
+
+		//k3; evaluated at y + 0.5 * dt * k2
+		const simd::vec v3x = ux + half_dt * a2x;
+		const simd::vec v3y = uy + half_dt * a2y;
+		const simd::vec v3z = uz + half_dt * a2z;
+		simd::vec a3x, a3y, a3z;
+		gravity(rx + half_dt * v2x, ry + half_dt * v2y, rz + half_dt * v2z, a3x, a3y, a3z,
+			    this->mu, this->eq_radius, this->j2, this->include_j2);
+
+		//k4; evaluated at y + dt * k3
+		const simd::vec v4x = ux + full_dt * a3x;
+		const simd::vec v4y = uy + full_dt * a3y;
+		const simd::vec v4z = uz + full_dt * a3z;
+		simd::vec a4x, a4y, a4z;
+		gravity(rx + full_dt * v3x, ry + full_dt * v3y, rz + full_dt * v3z, a4x, a4y, a4z,
+			    this->mu, this->eq_radius, this->j2, this->include_j2);
+
+		//y + (dt / 6) * (k1 + 2 * k2 + 2 * k3 + k4)
+		simd::store(&this->x[i], rx + sixth_dt * (ux + two * v2x + two * v3x + v4x));
+		simd::store(&this->y[i], ry + sixth_dt * (uy + two * v2y + two * v3y + v4y));
+		simd::store(&this->z[i], rz + sixth_dt * (uz + two * v2z + two * v3z + v4z));
+		simd::store(&this->vx[i], ux + sixth_dt * (a1x + two * a2x + two * a3x + a4x));
+		simd::store(&this->vy[i], uy + sixth_dt * (a1y + two * a2y + two * a3y + a4y));
+		simd::store(&this->vz[i], uz + sixth_dt * (a1z + two * a2z + two * a3z + a4z));
+	}
+}
+#pragma endregion utilities
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+#include "ForceModel.h"
+
+class BatchPropagator
+{
+public:
+	//structure-of-arrays propagator for a whole constellation; every satellite's state lives in contiguous
+	// x/y/z/vx/vy/vz arrays so the Keplerian + J2 EOMs and the RK4 stages can be evaluated several satellites
+	// at a time with SIMD (see simd_utils.h for the lane width)
+	//note: mirrors the math in ForceModel::eoms and astrokit::rk4_step so results match the per-spacecraft
+	//      path to within round-off
+	BatchPropagator(double mu, double eq_radius, double j2, bool include_j2);
+	BatchPropagator(const ForceModel& fm);
+
+	//getters
+	std::size_t get_count() const;
+	Eigen::Vector<double, 6> get_state(std::size_t i) const;
+
+	//setters
+	void set_state(std::size_t i, const Eigen::Vector<double, 6>& state);
+
+	//utilities
+	void load_states(const std::vector<Eigen::Vector<double, 6>>& states); //resizes the arrays and fills them with the given states
+	void step(double t, double dt); //fixed-step RK4 for every satellite in the batch
+	void step(double t, double dt, std::size_t lane0, std::size_t lanef); //only steps lanes [lane0, lanef)
+
+private:
+	double mu;
+	double eq_radius;
+	double j2;
+	bool include_j2;
+
+	std::size_t count; //number of real satellites; the arrays are padded out to a whole number of SIMD lanes
+
+	std::vector<double> x;
+	std::vector<double> y;
+	std::vector<double> z;
+	std::vector<double> vx;
+	std::vector<double> vy;
+	std::vector<double> vz;
+};
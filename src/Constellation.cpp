@@ -1,19 +1,31 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include "Constellation.h"
+#include "BatchPropagator.h"
+#include "simd_utils.h"
+#include "HistorySink.h"
+#include "HistoryFile.h"
 #include <astrokit/integrators.h>
+#include <astrokit/kepler.h>
+#include <astrokit/state_converter.h>
 
 Constellation::Constellation(Planet& cb, Integrator& integrator) : 
-	cb(cb), current_et(0.0), spacecraft{}, sc_bounds{}, integrator(integrator)
+	cb(cb), current_et(0.0), spacecraft{}, sc_bounds{}, integrator(integrator), shell_index{}
 {
 }
 
 Constellation::Constellation(Planet& cb, Integrator& integrator, double et0) : 
-	cb(cb), spacecraft{}, sc_bounds{}, integrator(integrator)
+	cb(cb), spacecraft{}, sc_bounds{}, integrator(integrator), shell_index{}
 {
 	set_et(et0);
 }
 
 Constellation::Constellation(Planet& cb, Integrator& integrator, double et0, std::vector<Spacecraft> sc_list, BoundingBox sc_bounds) : 
-	cb(cb), integrator(integrator)
+	cb(cb), integrator(integrator), shell_index{}
 {
 	set_et(et0);
 	this->spacecraft = sc_list; //provided a vector of already-initialized s/c to the constructor
@@ -35,6 +47,70 @@ BoundingBox Constellation::get_sc_bounds() const
 {
 	return this->sc_bounds;
 }
+
+PropagationOptions Constellation::get_prop_options() const
+{
+	return this->prop_options;
+}
+
+const std::vector<TrackingNeighbors>& Constellation::get_tracking_neighbors() const
+{
+	return this->tracking_neighbors;
+}
+
+std::vector<std::size_t> Constellation::get_orbit_planes() const
+{
+	//neighbor1 is the next slot in the same plane, so following those links partitions the constellation into planes
+	//note: planes are numbered in order of their lowest spacecraft index
+	const std::size_t n_sc = this->spacecraft.size();
+	std::vector<std::size_t> root(n_sc);
+	for (std::size_t i = 0; i < n_sc; i++)
+	{
+		root[i] = i;
+	}
+	auto find = [&](std::size_t i)
+	{
+		while (root[i] != i)
+		{
+			root[i] = root[root[i]];
+			i = root[i];
+		}
+		return i;
+	};
+	if (this->tracking_neighbors.size() == n_sc)
+	{
+		for (std::size_t i = 0; i < n_sc; i++)
+		{
+			std::size_t a = find(i);
+			std::size_t b = find(this->tracking_neighbors[i].neighbor1);
+			root[std::max(a, b)] = std::min(a, b);
+		}
+	}
+
+	std::vector<std::size_t> plane(n_sc);
+	std::unordered_map<std::size_t, std::size_t> plane_of_root;
+	for (std::size_t i = 0; i < n_sc; i++)
+	{
+		auto it = plane_of_root.emplace(find(i), plane_of_root.size()).first;
+		plane[i] = it->second;
+	}
+	return plane;
+}
+
+const ManeuverScheduler& Constellation::get_maneuvers() const
+{
+	return this->maneuvers;
+}
+
+const EventDetector& Constellation::get_events() const
+{
+	return this->events;
+}
+
+const std::vector<EventRecord>& Constellation::get_event_log(std::size_t sc_index) const
+{
+	return this->events.get_log(sc_index);
+}
 #pragma endregion getters
 
 #pragma region setters
@@ -47,27 +123,46 @@ void Constellation::set_sc_bounds(BoundingBox new_bounds)
 {
 	this->sc_bounds = new_bounds;
 }
+
+void Constellation::set_prop_options(PropagationOptions new_options)
+{
+	this->prop_options = new_options;
+}
+
+void Constellation::set_tracking_neighbors(std::vector<TrackingNeighbors> new_neighbors)
+{
+	this->tracking_neighbors = new_neighbors;
+}
+
+void Constellation::set_event_time_tol(double new_time_tol)
+{
+	this->events.set_time_tol(new_time_tol);
+}
 #pragma endregion setters
 
 #pragma region utilities
 void Constellation::add_spacecraft(Spacecraft new_sc)
 {
 	this->spacecraft.push_back(new_sc);
+	this->shell_index.clear();
 }
 
 void Constellation::add_spacecraft(std::string sc_name, State sc_state)
 {
 	this->spacecraft.push_back(Spacecraft(this->integrator, sc_name, sc_state));
+	this->shell_index.clear();
 }
 
 void Constellation::add_spacecraft(std::string sc_name, double et0, Eigen::Vector3d pos0, Eigen::Vector3d vel0)
 {
 	this->spacecraft.push_back(Spacecraft(this->integrator, sc_name, et0, pos0, vel0, cb.get_mu()));
+	this->shell_index.clear();
 }
 
 void Constellation::add_spacecraft(std::string sc_name, double et0, Eigen::Vector<double, 6> coes)
 {
 	this->spacecraft.push_back(Spacecraft(this->integrator, sc_name, et0, coes, cb.get_mu()));
+	this->shell_index.clear();
 }
 
 void Constellation::propagate(double duration, double step_size)
@@ -79,50 +174,757 @@ void Constellation::propagate(double duration, double step_size)
 	//note: it would be easier to just fully propagate each spacecraft at a time then compare time histories,
 	//      but propagating the full constellation together gives more modeling flexibility for future features
 	//also note: for now, we're assuming forward propagation only here
+	//only cartesian states are stored while stepping; the elements get converted in bulk when they're asked for
+	//the number of output rows is known up front, so size every history arena once instead of growing it
+	std::size_t n_new_rows = static_cast<std::size_t>(std::ceil(duration / step_size)) + 1;
+
+	//when streaming to a history sink, the arenas only have to hold the tracking window plus one chunk
+	HistorySink* sink = this->prop_options.history_sink.get();
+	std::size_t keep_rows = sink ? history_window_rows(step_size) : 0;
+	std::size_t chunk_rows = std::max<std::size_t>(this->prop_options.stream_chunk_rows, 1);
+
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		Spacecraft& sc = this->spacecraft[i];
+		sc.set_coe_history_enabled(this->prop_options.record_coe_history);
+		std::size_t arena_rows = sc.get_history().get_rows() + n_new_rows;
+		if (sink)
+		{
+			const HistoryArena& history = sc.get_history();
+			sink->reserve(i, sc.get_name(), history.has_coes(), history.get_first_row() + arena_rows);
+			arena_rows = std::min(arena_rows, std::max(history.get_rows(), keep_rows) + chunk_rows + 1);
+		}
+		sc.reserve_history(arena_rows);
+	}
+
+	//station keeping applies burns between output steps, which the closed-form paths can't take
+	bool station_keeping = this->prop_options.station_keeping;
+	if (station_keeping)
+	{
+		if (this->prop_options.mode == PropagationMode::mean_j2)
+		{
+			throw std::runtime_error("Station keeping needs one of the stepping propagation modes (not mean_j2).");
+		}
+		if (this->tracking_neighbors.size() != this->spacecraft.size())
+		{
+			throw std::runtime_error("Station keeping needs tracking neighbors for every spacecraft (see set_tracking_neighbors).");
+		}
+		this->maneuvers.set_lead_time(this->prop_options.maneuver_lead_time);
+		this->maneuvers.set_phasing_drift_periods(this->prop_options.phasing_drift_periods);
+	}
+
+	//picks up any rows added since the last propagate (or starts the scans off at the current states)
+	detect_events();
+
+	//the closed-form two-body path covers both stepping modes (mean_j2 already handles include_j2 = false itself)
+	if (!station_keeping && this->prop_options.mode != PropagationMode::mean_j2 && this->prop_options.analytic_two_body && this->integrator.get_fm().is_two_body())
+	{
+		propagate_two_body(duration, step_size, keep_rows);
+		return;
+	}
+	if (this->prop_options.mode == PropagationMode::batch)
+	{
+		propagate_batch(duration, step_size, keep_rows);
+		return;
+	}
+	if (this->prop_options.mode == PropagationMode::mean_j2)
+	{
+		propagate_mean_elements(duration, step_size, keep_rows);
+		return;
+	}
+
+	//spacecraft are split across the worker pool each step; parallel_for only returns once every spacecraft has
+	// finished the step, so the constellation stays in lockstep for any future coupled features
+	//with dense output, step_size is only the output cadence; each spacecraft integrates with its own (larger)
+	// steps and its state at every output epoch comes from the step's continuous extension
+	ThreadPool& pool = worker_pool();
+	bool dense = this->prop_options.dense_output;
+	double integration_step = (this->prop_options.integration_step > 0.0) ? this->prop_options.integration_step : step_size;
+	auto step_all = [&](double dt)
+	{
+		pool.parallel_for(this->spacecraft.size(), [&](std::size_t i0, std::size_t i1)
+		{
+			for (std::size_t i = i0; i < i1; i++)
+			{
+				Spacecraft& sc = this->spacecraft[i];
+				if (dense)
+				{
+					sc.advance_to(sc.get_et() + dt, integration_step);
+				}
+				else
+				{
+					sc.step(dt);
+				}
+			}
+		});
+	};
+
+	run_output_steps(duration, step_size, keep_rows, [&](double, double dt) { step_all(dt); }, nullptr);
+}
+
+void Constellation::propagate_batch(double duration, double step_size, std::size_t keep_rows)
+{
+	//same stepping pattern as propagate, but the states are packed into contiguous arrays once up front and
+	// every step advances the whole constellation through the SIMD kernels in BatchPropagator
+	//note: the batch kernels only know Keplerian + J2 with fixed-step RK4, which is exactly what ForceModel & Integrator
+	//      provide right now; the per-step copy back into each Spacecraft keeps the histories identical in layout
+	if (this->integrator.is_adaptive() || this->prop_options.dense_output)
+	{
+		throw std::runtime_error("Batch propagation only supports the fixed-step RK4 integrator without dense output.");
+	}
+	if (this->integrator.get_fm().get_gravity_degree() != 0 || !this->integrator.get_fm().get_third_bodies().empty())
+	{
+		throw std::runtime_error("Batch propagation only supports Keplerian + J2 gravity (no spherical harmonics or third bodies).");
+	}
+	BatchPropagator batch(this->integrator.get_fm());
+
+	std::vector<Eigen::Vector<double, 6>> states;
+	states.reserve(this->spacecraft.size());
+	for (const auto& sc : this->spacecraft)
+	{
+		const State state = sc.get_state();
+		Eigen::Vector<double, 6> cart;
+		cart << state.pos, state.vel;
+		states.push_back(cart);
+	}
+	batch.load_states(states);
+
+	double et0 = get_et();
+	ThreadPool& pool = worker_pool();
+	std::size_t n_blocks = simd::padded_size(batch.get_count()) / simd::WIDTH;
+	auto batch_step = [&](double t, double dt)
+	{
+		//threads split whole SIMD blocks of the batch, then copy their own spacecraft back out
+		pool.parallel_for(n_blocks, [&](std::size_t b0, std::size_t b1)
+		{
+			batch.step(t, dt, b0 * simd::WIDTH, b1 * simd::WIDTH);
+			for (std::size_t i = b0 * simd::WIDTH; i < std::min(b1 * simd::WIDTH, this->spacecraft.size()); i++)
+			{
+				Spacecraft& sc = this->spacecraft[i];
+				sc.set_cartesian_state(sc.get_et() + dt, batch.get_state(i));
+			}
+		});
+	};
+
+	//burns change a spacecraft's state behind the batch's back, so copy those back in
+	auto reload = [&](std::size_t i)
+	{
+		const State state = this->spacecraft[i].get_state();
+		Eigen::Vector<double, 6> cart;
+		cart << state.pos, state.vel;
+		batch.set_state(i, cart);
+	};
+
+	run_output_steps(duration, step_size, keep_rows, [&](double t_offset, double dt) { batch_step(et0 + t_offset, dt); }, reload);
+}
+
+void Constellation::propagate_mean_elements(double duration, double step_size, std::size_t keep_rows)
+{
+	//survey mode; no integration at all. each spacecraft's elements at the start of the call are treated as mean
+	// elements and only the first-order J2 secular drift (raan, argp & mean anomaly) is applied, so any output epoch
+	// costs one Kepler solve + coe_to_cart no matter how far it is from the start
+	//note: sma, ecc & inc stay fixed and there are no short-period terms, so the histories are mean-element
+	//      trajectories rather than osculating ones; fine for raan/phasing drift over months, not for precise ephemerides
+	struct MeanElements
+	{
+		double et0; //the spacecraft's own epoch; samples are offsets from it, not from the constellation clock
+		Eigen::Vector<double, 6> coes0;
+		double M0;
+		Eigen::Vector3d rates; //raan_dot, argp_dot, M_dot
+	};
+
+	const ForceModel& fm = this->integrator.get_fm();
+	if (fm.get_gravity_degree() != 0 || !fm.get_third_bodies().empty())
+	{
+		throw std::runtime_error("Mean-element propagation only supports Keplerian + J2 gravity (no spherical harmonics or third bodies).");
+	}
+	double mu = this->cb.get_mu();
+	double j2 = fm.get_include_j2() ? this->cb.get_j2() : 0.0;
+
+	std::vector<MeanElements> elements(this->spacecraft.size());
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		const State state = this->spacecraft[i].get_state();
+		MeanElements& el = elements[i];
+		el.et0 = state.et;
+		el.coes0 << state.sma, state.ecc, state.inc, state.raan, state.argp, state.ta;
+		if (el.coes0[1] >= 1.0)
+		{
+			throw std::runtime_error("Mean-element propagation only supports elliptic orbits; " + this->spacecraft[i].get_name() + " isn't one.");
+		}
+		el.M0 = astrokit::true_to_mean_anomaly(el.coes0[5], el.coes0[1]);
+		el.rates = astrokit::j2_secular_rates(el.coes0[0], el.coes0[1], el.coes0[2], mu, this->cb.get_eq_radius(), j2);
+	}
+
+	run_sampled_outputs(duration, step_size, keep_rows, [&](std::size_t i, const double* offsets, std::size_t n)
+	{
+		//every sample is measured from the start epoch, so there's no error build-up however many samples are taken
+		const MeanElements& el = elements[i];
+		Eigen::Vector<double, 6> coes = el.coes0;
+		Spacecraft& sc = this->spacecraft[i];
+		for (std::size_t k = 0; k < n; k++)
+		{
+			double t = offsets[k];
+			coes[3] = astrokit::wrap_2pi(el.coes0[3] + el.rates[0] * t);
+			coes[4] = astrokit::wrap_2pi(el.coes0[4] + el.rates[1] * t);
+			coes[5] = astrokit::mean_to_true_anomaly(el.M0 + el.rates[2] * t, el.coes0[1]);
+			sc.set_state_with_coes(el.et0 + t, astrokit::coe_to_cart(coes, mu), coes);
+		}
+	});
+}
+
+void Constellation::propagate_two_body(double duration, double step_size, std::size_t keep_rows)
+{
+	//point-mass gravity only, so every output state comes straight from the universal-variable Kepler solution of the
+	// state at the start of the call; exact (to the solver tolerance) whatever the step size or integrator
+	//note: offsets are measured from each spacecraft's own epoch (like the stepping modes' sc.get_et() + dt), not the
+	//      constellation clock; spacecraft added at other epochs keep their own time lines
+	std::vector<astrokit::UniversalKepler> orbits;
+	std::vector<double> sc_et0(this->spacecraft.size());
+	orbits.reserve(this->spacecraft.size());
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		const State state = this->spacecraft[i].get_state();
+		Eigen::Vector<double, 6> cart;
+		cart << state.pos, state.vel;
+		orbits.emplace_back(cart, this->cb.get_mu());
+		sc_et0[i] = state.et;
+	}
+
+	run_sampled_outputs(duration, step_size, keep_rows, [&](std::size_t i, const double* offsets, std::size_t n)
+	{
+		std::vector<Eigen::Vector<double, 6>> states(n);
+		orbits[i].states_at(offsets, n, states.data());
+		Spacecraft& sc = this->spacecraft[i];
+		for (std::size_t k = 0; k < n; k++)
+		{
+			sc.set_cartesian_state(sc_et0[i] + offsets[k], states[k]);
+		}
+	});
+}
+
+void Constellation::run_sampled_outputs(double duration, double step_size, std::size_t keep_rows,
+										const std::function<void(std::size_t, const double*, std::size_t)>& sample)
+//output loop for the closed-form modes; sample(i, offsets, n) appends spacecraft i's states at get_et() + offsets[0..n)
+//note: the samples don't depend on each other, so instead of a barrier per output step each thread fills a whole run
+//      of rows for its own spacecraft; with a history sink the runs are one stream chunk long
+{
+	//same output epochs as the stepping modes (full steps, then one partial step to land on the exact end time)
+	std::vector<double> offsets;
+	offsets.reserve(static_cast<std::size_t>(std::ceil(duration / step_size)));
 	double total_time = 0.0;
 	while (total_time + step_size < duration)
 	{
-		for (auto& sc : this->spacecraft)
+		total_time += step_size;
+		offsets.push_back(total_time);
+	}
+	if (total_time < duration)
+	{
+		offsets.push_back(duration);
+	}
+
+	HistorySink* sink = this->prop_options.history_sink.get();
+	std::size_t chunk_rows = sink ? std::max<std::size_t>(this->prop_options.stream_chunk_rows, 1) : offsets.size();
+	ThreadPool& pool = worker_pool();
+	for (std::size_t k0 = 0; k0 < offsets.size(); k0 += chunk_rows)
+	{
+		std::size_t n = std::min(chunk_rows, offsets.size() - k0);
+		pool.parallel_for(this->spacecraft.size(), [&](std::size_t i0, std::size_t i1)
+		{
+			for (std::size_t i = i0; i < i1; i++)
+			{
+				sample(i, offsets.data() + k0, n);
+			}
+		});
+		detect_events();
+		if (sink)
 		{
-			sc.step(step_size);
+			stream_histories(keep_rows);
 		}
+	}
+	if (sink)
+	{
+		sink->finish();
+	}
+	set_et(get_et() + duration);
+}
+
+void Constellation::run_output_steps(double duration, double step_size, std::size_t keep_rows,
+									 const std::function<void(double, double)>& step_all,
+									 const std::function<void(std::size_t)>& state_changed)
+//shared output loop for the stepping modes; step_all(t_offset, dt) advances every spacecraft by dt from
+// get_et() + t_offset and appends one history row each
+//state_changed(i) (optional) hears about spacecraft whose state station keeping changed between steps
+{
+	bool station_keeping = this->prop_options.station_keeping;
+	HistorySink* sink = this->prop_options.history_sink.get();
+	std::size_t chunk_rows = std::max<std::size_t>(this->prop_options.stream_chunk_rows, 1);
+
+	double total_time = 0.0;
+	std::size_t pending_steps = 0; //output steps since the last flush to the history sink
+	while (total_time + step_size < duration)
+	{
+		step_all(total_time, step_size);
 		total_time += step_size;
+		if (station_keeping)
+		{
+			station_keeping_pass(state_changed);
+		}
+		detect_events();
+		if (sink && ++pending_steps >= chunk_rows)
+		{
+			stream_histories(keep_rows);
+			pending_steps = 0;
+		}
 	}
 	if (total_time < duration) //we need one more partial step; want to always include the exact final time in the output
 	{
-		double partial_step = duration - total_time;
-		for (auto& sc : this->spacecraft)
+		step_all(total_time, duration - total_time);
+		if (station_keeping)
+		{
+			station_keeping_pass(state_changed);
+		}
+		detect_events();
+	}
+	if (sink)
+	{
+		stream_histories(keep_rows);
+		sink->finish();
+	}
+	set_et(get_et() + duration);
+}
+
+void Constellation::station_keeping_pass(const std::function<void(std::size_t)>& state_changed)
+{
+	//runs between steps on the calling thread; the order of everything here is fixed, so burns (and the histories)
+	// don't depend on the thread count
+	if (this->spacecraft.empty())
+	{
+		return;
+	}
+	double et = this->spacecraft[0].get_et();
+	double mu = this->cb.get_mu();
+
+	//fold the new row into every spacecraft's tracking means, then a single pass over the tracking states: anyone
+	// outside the box (with nothing already queued) gets burns planned
+	update_tracking();
+	if (this->shell_index.empty())
+	{
+		align_shell_refs();
+		if (this->shell_index.empty())
+		{
+			return; //not everyone has a full period of tracking yet
+		}
+	}
+
+	//raan is held relative to the rest of the shell: first-order J2 gets the node rate wrong by ~1e-3 of itself, which
+	// would walk every plane out of the box together; the spacing between the planes is what matters
+	std::size_t n_shells = *std::max_element(this->shell_index.begin(), this->shell_index.end()) + 1;
+	std::vector<double> shell_raan_error(n_shells, 0.0);
+	std::vector<std::size_t> shell_count(n_shells, 0);
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		if (this->spacecraft[i].has_full_tracking_window())
 		{
-			sc.step(partial_step);
+			shell_raan_error[this->shell_index[i]] += this->spacecraft[i].get_raan_error();
+			shell_count[this->shell_index[i]]++;
 		}
 	}
+	for (std::size_t k = 0; k < n_shells; k++)
+	{
+		shell_raan_error[k] = (shell_count[k] > 0) ? shell_raan_error[k] / shell_count[k] : 0.0;
+	}
+
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		if (this->maneuvers.has_pending(i))
+		{
+			continue;
+		}
+		const Spacecraft& sc = this->spacecraft[i];
+		double raan_offset = shell_raan_error[this->shell_index[i]];
+		BoundsCheck violations = sc.check_bounds(this->sc_bounds, raan_offset);
+		if (violations.any())
+		{
+			this->maneuvers.plan(i, sc, violations, et, mu, raan_offset);
+		}
+	}
+
+	//then apply whatever is due by now; only the spacecraft burning change state, everyone else carries on as normal
+	std::vector<Maneuver> due = this->maneuvers.pop_due(et);
+	if (due.empty())
+	{
+		return;
+	}
+
+	//each burning spacecraft logs its post-burn state as a zero-length row after its last burn, so the interpolants
+	// (events, eclipses, links, access) never straddle the velocity jump. everyone else repeats their current row at
+	// the same epoch, which keeps the histories in lockstep
+	std::vector<std::size_t> burns_left(this->spacecraft.size(), 0);
+	for (const Maneuver& burn : due)
+	{
+		burns_left[burn.sc_index]++;
+	}
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		if (burns_left[i] == 0)
+		{
+			this->spacecraft[i].repeat_history_row();
+		}
+	}
+
+	for (Maneuver burn : due)
+	{
+		Spacecraft& sc = this->spacecraft[burn.sc_index];
+		const State state = sc.get_state();
+		Eigen::Vector3d r_hat = state.pos.normalized();
+		Eigen::Vector3d n_hat = state.pos.cross(state.vel).normalized();
+		Eigen::Vector3d t_hat = n_hat.cross(r_hat);
+		sc.apply_dv(burn.dv_rtn[0] * r_hat + burn.dv_rtn[1] * t_hat + burn.dv_rtn[2] * n_hat, --burns_left[burn.sc_index] == 0);
+		sc.reset_tracking(); //the means have to start over from the new orbit
+		if (state_changed)
+		{
+			state_changed(burn.sc_index);
+		}
+		burn.et = et;
+		this->maneuvers.record(burn);
+	}
+}
+
+void Constellation::align_shell_refs()
+{
+	//spacecraft started on the same osculating sma at different arguments of latitude end up with different mean sma
+	// (J2 short-period terms), so left alone they drift apart in phase. everyone sharing a reference conic sma & inc
+	// (e.g. one Walker shell) gets the shell's average mean sma & inc as the reference instead, which the sma & plane
+	// burns then hold them to
+	for (const auto& sc : this->spacecraft)
+	{
+		if (!sc.has_tracking_ref())
+		{
+			return;
+		}
+	}
+
+	struct ShellSums
+	{
+		std::size_t index = 0;
+		double sma = 0.0;
+		double inc = 0.0;
+		std::size_t count = 0;
+	};
+	std::map<std::pair<double, double>, ShellSums> shells;
+	std::vector<ShellSums*> sc_shells;
+	for (const auto& sc : this->spacecraft)
+	{
+		auto [it, added] = shells.try_emplace({ sc.get_ref_conic().sma, sc.get_ref_conic().inc });
+		ShellSums& shell = it->second;
+		if (added)
+		{
+			shell.index = shells.size() - 1;
+		}
+		shell.sma += sc.get_tracking_ref().sma_mean;
+		shell.inc += sc.get_tracking_ref().inc_mean;
+		shell.count++;
+		sc_shells.push_back(&shell);
+	}
+
+	this->shell_index.resize(this->spacecraft.size());
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		const ShellSums& shell = *sc_shells[i];
+		TrackingState ref = this->spacecraft[i].get_tracking_ref();
+		ref.sma_mean = shell.sma / shell.count;
+		ref.inc_mean = shell.inc / shell.count;
+		this->spacecraft[i].set_tracking_ref(ref);
+		this->shell_index[i] = shell.index;
+	}
+}
+
+void Constellation::stream_histories(std::size_t keep_rows)
+{
+	//runs between steps on the calling thread, so the sink never sees concurrent writes
+	HistorySink& sink = *this->prop_options.history_sink;
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		this->spacecraft[i].stream_history(sink, i, keep_rows);
+	}
+}
+
+std::size_t Constellation::history_window_rows(double step_size) const
+{
+	//update_tracking averages over the last reference period, so keep at least that much (plus a row either side)
+	double longest_period = 0.0;
+	for (const auto& sc : this->spacecraft)
+	{
+		longest_period = std::max(longest_period, sc.get_ref_period());
+	}
+	return static_cast<std::size_t>(std::ceil(longest_period / step_size)) + 2;
+}
+
+void Constellation::update_tracking()
+{
+	std::size_t n_sc = this->spacecraft.size();
+	if (n_sc == 0)
+	{
+		return;
+	}
+	if (this->tracking_neighbors.size() != n_sc)
+	{
+		throw std::runtime_error("Constellation tracking neighbors need one entry per spacecraft.");
+	}
+
+	//every spacecraft has to be on the same overall rows (lockstep); start from whoever is furthest behind
+	const HistoryArena& h0 = this->spacecraft[0].get_history();
+	std::size_t first_row = h0.get_first_row();
+	std::size_t end_row = first_row + h0.get_rows();
+	std::size_t row0 = end_row;
+	for (std::size_t i = 0; i < n_sc; i++)
+	{
+		const Spacecraft& sc = this->spacecraft[i];
+		const TrackingNeighbors& nb = this->tracking_neighbors[i];
+		if (sc.get_history().get_first_row() != first_row || sc.get_history().get_rows() != h0.get_rows())
+		{
+			throw std::runtime_error("Constellation::update_tracking needs every spacecraft on the same history rows.");
+		}
+		if (nb.neighbor1 >= n_sc || nb.neighbor2 >= n_sc)
+		{
+			throw std::runtime_error("Spacecraft " + sc.get_name() + " has a tracking neighbor outside the constellation.");
+		}
+		row0 = std::min(row0, sc.get_tracking_next_row());
+	}
+	std::size_t n_rows = end_row - row0;
+
+	//phase angles for every spacecraft & new row; spacecraft i's angles are contiguous (i * n_rows + k)
+	std::vector<double> n1_angles(n_sc * n_rows);
+	std::vector<double> n2_angles(n_sc * n_rows);
+
+	//one shared position buffer per row, with each neighbor's position gathered into lane-aligned copies
+	//note: the padding lanes are unit vectors so the spare lanes stay finite
+	std::size_t n_pad = simd::padded_size(n_sc);
+	std::vector<double> x(n_pad, 1.0), y(n_pad, 0.0), z(n_pad, 0.0);
+	std::vector<double> x1(n_pad, 1.0), y1(n_pad, 0.0), z1(n_pad, 0.0);
+	std::vector<double> x2(n_pad, 1.0), y2(n_pad, 0.0), z2(n_pad, 0.0);
+	std::vector<double> cos1(n_pad), cos2(n_pad);
+	for (std::size_t k = 0; k < n_rows; k++)
+	{
+		std::size_t ix = row0 + k - first_row;
+		for (std::size_t i = 0; i < n_sc; i++)
+		{
+			Eigen::Vector<double, 6> cart = this->spacecraft[i].get_history().cart_at(ix);
+			x[i] = cart[0];
+			y[i] = cart[1];
+			z[i] = cart[2];
+		}
+		for (std::size_t i = 0; i < n_sc; i++)
+		{
+			const TrackingNeighbors& nb = this->tracking_neighbors[i];
+			x1[i] = x[nb.neighbor1];
+			y1[i] = y[nb.neighbor1];
+			z1[i] = z[nb.neighbor1];
+			x2[i] = x[nb.neighbor2];
+			y2[i] = y[nb.neighbor2];
+			z2[i] = z[nb.neighbor2];
+		}
+
+		//cos(angle) = a.b / sqrt(|a|^2 |b|^2), clamped against rounding (like astrokit::safe_acos)
+		const simd::vec one = simd::broadcast(1.0);
+		const simd::vec minus_one = simd::broadcast(-1.0);
+		for (std::size_t i = 0; i < n_pad; i += simd::WIDTH)
+		{
+			simd::vec ax = simd::load(&x[i]), ay = simd::load(&y[i]), az = simd::load(&z[i]);
+			simd::vec aa = ax * ax + ay * ay + az * az;
+
+			simd::vec bx = simd::load(&x1[i]), by = simd::load(&y1[i]), bz = simd::load(&z1[i]);
+			simd::vec c = (ax * bx + ay * by + az * bz) / simd::sqrt(aa * (bx * bx + by * by + bz * bz));
+			simd::store(&cos1[i], simd::min(simd::max(c, minus_one), one));
+
+			bx = simd::load(&x2[i]), by = simd::load(&y2[i]), bz = simd::load(&z2[i]);
+			c = (ax * bx + ay * by + az * bz) / simd::sqrt(aa * (bx * bx + by * by + bz * bz));
+			simd::store(&cos2[i], simd::min(simd::max(c, minus_one), one));
+		}
+		for (std::size_t i = 0; i < n_sc; i++)
+		{
+			n1_angles[i * n_rows + k] = std::acos(cos1[i]);
+			n2_angles[i * n_rows + k] = std::acos(cos2[i]);
+		}
+	}
+
+	//each spacecraft folds its rows into its own rolling window (filling in elements as needed), so they're independent
+	worker_pool().parallel_for(n_sc, [&](std::size_t i0, std::size_t i1)
+	{
+		for (std::size_t i = i0; i < i1; i++)
+		{
+			this->spacecraft[i].update_tracking(row0, &n1_angles[i * n_rows], &n2_angles[i * n_rows]);
+		}
+	});
+}
+
+std::size_t Constellation::add_event(std::string name, EventFunction g)
+{
+	return add_event(name, g, EventDirection::any, nullptr);
+}
+
+std::size_t Constellation::add_event(std::string name, EventFunction g, EventDirection direction, EventCallback callback)
+{
+	return add_event(EventDefinition{ name, g, direction, callback, true });
+}
+
+std::size_t Constellation::add_event(EventDefinition event)
+{
+	return this->events.add_event(std::move(event));
+}
+
+void Constellation::clear_events()
+{
+	this->events.clear_events();
+}
+
+void Constellation::clear_event_logs()
+{
+	this->events.clear_logs();
+}
+
+void Constellation::detect_events()
+{
+	if (this->events.get_event_count() == 0)
+	{
+		return;
+	}
+	this->events.detect(this->spacecraft, this->cb.get_mu(), worker_pool());
+}
+
+std::vector<AccessInterval> Constellation::compute_station_access()
+{
+	AccessAnalyzer access(this->cb);
+	return access.compute_access(this->spacecraft, worker_pool());
+}
+
+std::vector<LinkInterval> Constellation::compute_links(double max_range, double grazing_margin)
+{
+	LinkAnalyzer links(this->cb, max_range, grazing_margin, 1e-3);
+	return links.compute_links(this->spacecraft, worker_pool());
+}
+
+EclipseReport Constellation::compute_eclipses()
+{
+	EclipseAnalyzer eclipses(this->cb);
+	return eclipses.compute(this->spacecraft, get_orbit_planes(), worker_pool());
+}
+
+std::vector<LinkSample> Constellation::compute_link_geometry(std::size_t row, double max_range, double grazing_margin) const
+{
+	LinkAnalyzer links(this->cb, max_range, grazing_margin, 1e-3);
+	return links.compute_geometry(this->spacecraft, row);
 }
+
 void Constellation::save_spacecraft_histories(std::string file_name_root)
 {
-	//store spacecraft names as they're used to name the output files; want to make sure there are no duplicates
-	std::vector<std::string> used_names{};
+	save_spacecraft_histories(file_name_root, HistoryFormat::csv);
+}
+
+void Constellation::save_spacecraft_histories(std::string file_name_root, HistoryFormat format)
+{
+	save_spacecraft_histories_async(file_name_root, format);
+	wait_for_saves();
+}
 
-	//loop through each spacecraft in the constellation and have them write their state histories
-	for (auto& sc : this->spacecraft)
+void Constellation::save_spacecraft_histories_async(std::string file_name_root, HistoryFormat format)
+{
+	//the spacecraft names are used to name the output files; want to make sure there are no duplicates, since each
+	// file is written by its own I/O job
+	//note: a repeated name gets a counter appended, bumped until the name is free (see HistoryFile::unique_file_name)
+	std::unordered_set<std::string> used_names;
+	std::vector<std::string> file_names(this->spacecraft.size());
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
 	{
-		std::string sc_name = sc.get_name();
+		//appending the file type here instead of in Spacecraft; may change later
+		file_names[i] = HistoryFile::unique_file_name(file_name_root + this->spacecraft[i].get_name(),
+													   (format == HistoryFormat::binary) ? ".bin" : ".csv", used_names);
+	}
 
-		//check how many times the spacecraft name has already appeared
-		int counter = 0;
-		for (std::size_t i = 0; i < used_names.size(); i++)
+	//finish the lazy element conversion across the compute pool, then take compact copies of the histories so the
+	// writers never touch the live arenas (the constellation can keep propagating while they run)
+	std::vector<std::shared_ptr<const HistoryArena>> snapshots(this->spacecraft.size());
+	worker_pool().parallel_for(this->spacecraft.size(), [&](std::size_t i0, std::size_t i1)
+	{
+		for (std::size_t i = i0; i < i1; i++)
 		{
-			if (sc_name == used_names[i])
+			this->spacecraft[i].history_row_count_validation(); //sanity check
+			this->spacecraft[i].update_coe_history();
+			snapshots[i] = std::make_shared<const HistoryArena>(this->spacecraft[i].get_history().snapshot());
+		}
+	});
+
+	ThreadPool& io = io_pool();
+	for (std::size_t i = 0; i < this->spacecraft.size(); i++)
+	{
+		std::string sc_name = this->spacecraft[i].get_name();
+		std::shared_ptr<const HistoryArena> history = snapshots[i];
+		std::string file_name = file_names[i];
+		this->pending_saves.push_back(io.submit([history, sc_name, file_name, format]
+		{
+			if (format == HistoryFormat::binary)
+			{
+				HistoryFile::write(file_name, sc_name, "J2000", *history);
+			}
+			else
 			{
-				counter++;
+				HistoryFile::write_csv(file_name, *history);
 			}
+		}));
+	}
+}
+
+void Constellation::wait_for_saves()
+{
+	//wait on every write before reporting the first failure so no writer is left running
+	std::exception_ptr first_error = nullptr;
+	for (auto& save : this->pending_saves)
+	{
+		try
+		{
+			save.get();
 		}
-		std::string file_name = file_name_root + sc_name;
-		if (counter > 0)
+		catch (...)
 		{
-			file_name += std::to_string(counter);
+			if (!first_error)
+			{
+				first_error = std::current_exception();
+			}
 		}
-		sc.write_history_to_csv(file_name + ".csv"); //appending the csv file type here instead of in Spacecraft; may change later
 	}
+	this->pending_saves.clear();
+
+	if (first_error)
+	{
+		std::rethrow_exception(first_error);
+	}
+}
+
+ThreadPool& Constellation::worker_pool()
+{
+	std::size_t n_threads = this->prop_options.num_threads;
+	if (n_threads == 0)
+	{
+		n_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	if (!this->pool || this->pool->get_thread_count() != n_threads)
+	{
+		this->pool = std::make_unique<ThreadPool>(n_threads);
+	}
+	return *this->pool;
+}
+
+ThreadPool& Constellation::io_pool()
+{
+	//the calling thread never works submitted jobs, so the pool gets one extra thread to end up with num_io_threads workers
+	std::size_t n_threads = this->prop_options.num_io_threads + 1;
+	if (!this->io_pool_ptr || this->io_pool_ptr->get_thread_count() != n_threads)
+	{
+		wait_for_saves(); //don't drop a pool that still has writes queued
+		this->io_pool_ptr = std::make_unique<ThreadPool>(n_threads);
+	}
+	return *this->io_pool_ptr;
 }
 #pragma endregion utilities
 
@@ -1,8 +1,16 @@
 
 #pragma once
+#include <memory>
+#include <functional>
 #include "Planet.h"
 #include "Spacecraft.h"
 #include "Integrator.h"
+#include "ThreadPool.h"
+#include "AccessAnalyzer.h"
+#include "LinkAnalyzer.h"
+#include "EclipseAnalyzer.h"
+#include "ManeuverScheduler.h"
+#include "EventDetector.h"
 
 class Constellation
 {
@@ -21,10 +29,19 @@ public:
 	const std::vector<Spacecraft>& get_sats() const;
 	double get_et() const;
 	BoundingBox get_sc_bounds() const;
+	PropagationOptions get_prop_options() const;
+	const std::vector<TrackingNeighbors>& get_tracking_neighbors() const;
+	std::vector<std::size_t> get_orbit_planes() const; //plane index per spacecraft, following the in-plane tracking neighbors (each spacecraft its own plane without them)
+	const ManeuverScheduler& get_maneuvers() const; //station-keeping burns still queued plus the executed-burn ledger & per-spacecraft delta-v totals
+	const EventDetector& get_events() const; //registered events & their per-spacecraft logs
+	const std::vector<EventRecord>& get_event_log(std::size_t sc_index) const; //logged events for one spacecraft, in time order
 
 	//setters
 	void set_et(double new_et);
 	void set_sc_bounds(BoundingBox new_bounds);
+	void set_prop_options(PropagationOptions new_options);
+	void set_tracking_neighbors(std::vector<TrackingNeighbors> new_neighbors); //one entry per spacecraft (WalkerDelta fills these in)
+	void set_event_time_tol(double new_time_tol); //[s]; event times are refined to within this
 
 	//utilities
 	void add_spacecraft(Spacecraft new_sc);
@@ -37,10 +54,49 @@ public:
 	void propagate(double duration, double step_size);
 	//note: want to propagate every spacecraft in the constellation for each step before moving on
 
+	std::size_t add_event(std::string name, EventFunction g);
+	std::size_t add_event(std::string name, EventFunction g, EventDirection direction, EventCallback callback);
+	std::size_t add_event(EventDefinition event);
+	//note: returns the event's index (EventRecord::event_index). events are located during propagate, between output
+	//      steps, on every spacecraft (see EventDetector); g must be thread-safe & callbacks run on the calling thread
+	void clear_events(); //drops the events & their logs
+	void clear_event_logs();
+
+	void update_tracking(); //every spacecraft's TrackingState from the tracking neighbors, in one pass
+	//note: the phase angles for the whole constellation come from one shared position buffer per history row (SIMD over
+	//      spacecraft), then each spacecraft folds its new rows into its rolling means (see Spacecraft::update_tracking).
+	//      cheap enough to run after every propagate step
+
+	std::vector<AccessInterval> compute_station_access(); //AOS/LOS intervals for every spacecraft x central body station (see AccessAnalyzer)
+	std::vector<LinkInterval> compute_links(double max_range, double grazing_margin); //ISL up/down intervals for every pair (see LinkAnalyzer)
+	EclipseReport compute_eclipses(); //umbra/penumbra intervals for every spacecraft & beta angles per orbit plane (see EclipseAnalyzer)
+	std::vector<LinkSample> compute_link_geometry(std::size_t row, double max_range, double grazing_margin) const; //pairs in link range at one history row
+
 	void save_spacecraft_histories(std::string file_name_root); 
-	//note: each spacecraft writes its own csv; will use the spacecraft name appended to the file_name_root for each csv
+	void save_spacecraft_histories(std::string file_name_root, HistoryFormat format);
+	//note: each spacecraft writes its own file (.csv or .bin); will use the spacecraft name appended to the file_name_root for each file
+	void save_spacecraft_histories_async(std::string file_name_root, HistoryFormat format);
+	//note: snapshots the histories and hands the files to background I/O threads (prop_options.num_io_threads), then returns;
+	//      safe to keep propagating while they write. call wait_for_saves to join them and pick up any write errors
+	void wait_for_saves();
 
 private:
+	void propagate_batch(double duration, double step_size, std::size_t keep_rows); //PropagationMode::batch version of propagate
+	void propagate_mean_elements(double duration, double step_size, std::size_t keep_rows); //PropagationMode::mean_j2 version of propagate
+	void propagate_two_body(double duration, double step_size, std::size_t keep_rows); //closed-form path when the force model is point-mass only
+	void run_output_steps(double duration, double step_size, std::size_t keep_rows, const std::function<void(double, double)>& step_all,
+						  const std::function<void(std::size_t)>& state_changed);
+	void station_keeping_pass(const std::function<void(std::size_t)>& state_changed); //tracking, bounds checks & due burns after an output step
+	void align_shell_refs(); //shared sma & inc station-keeping references per shell, once everyone has tracked a full period
+	//note: a shell is every spacecraft with the same reference conic sma & inc (e.g. one Walker shell)
+	void detect_events(); //locates events in the rows added since the last call; no-op without any events
+	void run_sampled_outputs(double duration, double step_size, std::size_t keep_rows,
+							 const std::function<void(std::size_t, const double*, std::size_t)>& sample);
+	void stream_histories(std::size_t keep_rows); //flushes every spacecraft's unwritten rows to prop_options.history_sink
+	std::size_t history_window_rows(double step_size) const; //rows each spacecraft keeps in memory while streaming
+	ThreadPool& worker_pool(); //(re)builds the pool if the requested thread count changed
+	ThreadPool& io_pool(); //background pool for save_spacecraft_histories_async
+
 	Planet& cb;
 	Integrator& integrator;
 
@@ -48,5 +104,14 @@ private:
 	BoundingBox sc_bounds;
 	double current_et;
 
+	PropagationOptions prop_options;
+	std::vector<TrackingNeighbors> tracking_neighbors;
+	ManeuverScheduler maneuvers;
+	EventDetector events;
+	std::vector<std::size_t> shell_index; //station-keeping shell of each spacecraft; empty until align_shell_refs has run (cleared whenever spacecraft are added)
+	std::unique_ptr<ThreadPool> pool;
+	std::unique_ptr<ThreadPool> io_pool_ptr;
+	std::vector<std::future<void>> pending_saves; //outstanding background writes
+
 };
 
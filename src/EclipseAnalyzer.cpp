@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "EclipseAnalyzer.h"
+#include "simd_utils.h"
+#include <astrokit/math_utils.h>
+#include <astrokit/integrators.h>
+
+EclipseAnalyzer::EclipseAnalyzer(Planet& cb) : cb(cb), sun_radius(SUN_RADIUS), time_tol(1e-3)
+{
+}
+
+EclipseAnalyzer::EclipseAnalyzer(Planet& cb, double sun_radius, double time_tol) : cb(cb)
+{
+	set_sun_radius(sun_radius);
+	set_time_tol(time_tol);
+}
+
+#pragma region getters
+double EclipseAnalyzer::get_sun_radius() const
+{
+	return this->sun_radius;
+}
+
+double EclipseAnalyzer::get_time_tol() const
+{
+	return this->time_tol;
+}
+#pragma endregion getters
+
+#pragma region setters
+void EclipseAnalyzer::set_sun_radius(double new_sun_radius)
+{
+	if (new_sun_radius <= 0.0)
+	{
+		throw std::runtime_error("Sun radius must be positive.");
+	}
+	this->sun_radius = new_sun_radius;
+}
+
+void EclipseAnalyzer::set_time_tol(double new_time_tol)
+{
+	if (new_time_tol <= 0.0)
+	{
+		throw std::runtime_error("Eclipse time tolerance must be positive.");
+	}
+	this->time_tol = new_time_tol;
+}
+#pragma endregion setters
+
+#pragma region utilities
+EclipseReport EclipseAnalyzer::compute(const std::vector<Spacecraft>& sats, const std::vector<std::size_t>& plane_index) const
+{
+	ThreadPool serial(1);
+	return compute(sats, plane_index, serial);
+}
+
+EclipseReport EclipseAnalyzer::compute(const std::vector<Spacecraft>& sats, const std::vector<std::size_t>& plane_index,
+									   ThreadPool& pool) const
+{
+	EclipseReport report;
+	if (sats.empty())
+	{
+		return report;
+	}
+	HistoryArena::ConstColumn et = sats[0].get_et_history();
+	for (const auto& sc : sats)
+	{
+		HistoryArena::ConstColumn sc_et = sc.get_et_history();
+		if (sc_et.size() != et.size() || !std::equal(sc_et.begin(), sc_et.end(), et.begin()))
+		{
+			throw std::runtime_error("Eclipse analysis needs every spacecraft on the same output epochs.");
+		}
+	}
+	report.et.assign(et.begin(), et.end());
+	const std::size_t n_rows = report.et.size();
+
+	//orbit planes
+	if (plane_index.empty())
+	{
+		report.plane_index.resize(sats.size());
+		std::iota(report.plane_index.begin(), report.plane_index.end(), std::size_t(0));
+	}
+	else if (plane_index.size() != sats.size())
+	{
+		throw std::runtime_error("Eclipse analysis needs one orbit plane index per spacecraft.");
+	}
+	else
+	{
+		report.plane_index = plane_index;
+	}
+	std::vector<std::vector<std::size_t>> members(*std::max_element(report.plane_index.begin(), report.plane_index.end()) + 1);
+	for (std::size_t i = 0; i < sats.size(); i++)
+	{
+		members[report.plane_index[i]].push_back(i);
+	}
+	report.beta.resize(members.size());
+	if (n_rows == 0)
+	{
+		return report;
+	}
+
+	//one sun lookup per epoch for everyone; any SPICE calls happen here, serially, before anything runs in parallel
+	const std::vector<Eigen::Vector3d> sun_pos = this->cb.body_positions(SUN_SPKID, report.et);
+	const std::size_t n_pad = simd::padded_size(n_rows);
+	SunTable sun;
+	for (auto* column : { &sun.x, &sun.y, &sun.z, &sun.ux, &sun.uy, &sun.uz })
+	{
+		column->resize(n_pad);
+	}
+	for (std::size_t k = 0; k < n_pad; k++)
+	{
+		const Eigen::Vector3d& s = sun_pos[std::min(k, n_rows - 1)]; //padding repeats the last epoch
+		const Eigen::Vector3d u = s.normalized();
+		sun.x[k] = s.x();
+		sun.y[k] = s.y();
+		sun.z[k] = s.z();
+		sun.ux[k] = u.x();
+		sun.uy[k] = u.y();
+		sun.uz[k] = u.z();
+	}
+
+	std::vector<std::vector<EclipseInterval>> per_sc(sats.size());
+	pool.parallel_for(sats.size(), [&](std::size_t i0, std::size_t i1)
+	{
+		for (std::size_t i = i0; i < i1; i++)
+		{
+			shadow_for_spacecraft(sats[i], i, report.et, sun, per_sc[i]);
+		}
+	});
+	pool.parallel_for(members.size(), [&](std::size_t p0, std::size_t p1)
+	{
+		for (std::size_t p = p0; p < p1; p++)
+		{
+			beta_for_plane(sats, members[p], sun, n_rows, report.beta[p]);
+		}
+	});
+
+	for (const auto& sc_intervals : per_sc)
+	{
+		report.eclipses.insert(report.eclipses.end(), sc_intervals.begin(), sc_intervals.end());
+	}
+	return report;
+}
+
+EclipseAnalyzer::ShadowMargins EclipseAnalyzer::shadow_margins(const Eigen::Vector3d& r, const Eigen::Vector3d& r_sun) const
+{
+	//scalar twin of the SIMD kernel in shadow_for_spacecraft (used during refinement)
+	const Eigen::Vector3d d = r_sun - r;
+	const double r2 = r.squaredNorm();
+	const double d2 = d.squaredNorm();
+	const double cos_c = -r.dot(d) / std::sqrt(r2 * d2);
+	const double sin_a = this->sun_radius / std::sqrt(d2);
+	const double sin_b = this->cb.get_mean_radius() / std::sqrt(r2);
+	const double cos_a = std::sqrt(std::max(1.0 - sin_a * sin_a, 0.0));
+	const double cos_b = std::sqrt(std::max(1.0 - sin_b * sin_b, 0.0));
+	return ShadowMargins{ cos_a * cos_b - sin_a * sin_b - cos_c, std::max(cos_a * cos_b + sin_a * sin_b - cos_c, sin_a - sin_b) };
+}
+
+void EclipseAnalyzer::shadow_for_spacecraft(const Spacecraft& sc, std::size_t sc_index, const std::vector<double>& et,
+											const SunTable& sun, std::vector<EclipseInterval>& intervals) const
+{
+	const std::size_t n_rows = et.size();
+	const std::size_t n_pad = simd::padded_size(n_rows);
+
+	//positions into padded buffers so the kernel runs on whole SIMD lanes
+	thread_local std::vector<double> rx, ry, rz, penumbra, umbra;
+	HistoryArena::ConstBlock cart = sc.get_cartesian_history();
+	for (auto* column : { &rx, &ry, &rz, &penumbra, &umbra })
+	{
+		column->resize(n_pad);
+	}
+	for (std::size_t k = 0; k < n_pad; k++)
+	{
+		const std::size_t row = std::min(k, n_rows - 1);
+		rx[k] = cart(row, 0);
+		ry[k] = cart(row, 1);
+		rz[k] = cart(row, 2);
+	}
+
+	//cos(a + b) - cos(c) < 0 in penumbra, cos(b - a) - cos(c) < 0 in umbra; when the sun's disk looks bigger than the
+	// body's (b < a) there's no umbra, which the max against sin(a) - sin(b) takes care of
+	const simd::vec zero = simd::broadcast(0.0);
+	const simd::vec one = simd::broadcast(1.0);
+	const simd::vec r_sun = simd::broadcast(this->sun_radius);
+	const simd::vec r_body = simd::broadcast(this->cb.get_mean_radius());
+	for (std::size_t k = 0; k < n_pad; k += simd::WIDTH)
+	{
+		simd::vec px = simd::load(&rx[k]), py = simd::load(&ry[k]), pz = simd::load(&rz[k]);
+		simd::vec dx = simd::load(&sun.x[k]) - px, dy = simd::load(&sun.y[k]) - py, dz = simd::load(&sun.z[k]) - pz;
+		simd::vec r2 = px * px + py * py + pz * pz;
+		simd::vec d2 = dx * dx + dy * dy + dz * dz;
+
+		simd::vec cos_c = (zero - (px * dx + py * dy + pz * dz)) / simd::sqrt(r2 * d2);
+		simd::vec sin_a = r_sun / simd::sqrt(d2);
+		simd::vec sin_b = r_body / simd::sqrt(r2);
+		simd::vec cos_ab = simd::sqrt(simd::max(one - sin_a * sin_a, zero)) * simd::sqrt(simd::max(one - sin_b * sin_b, zero));
+		simd::vec sin_ab = sin_a * sin_b;
+		simd::store(&penumbra[k], cos_ab - sin_ab - cos_c);
+		simd::store(&umbra[k], simd::max(cos_ab + sin_ab - cos_c, sin_a - sin_b));
+	}
+
+	//shadow entries & exits for each cone; umbra is always inside penumbra, so sorting by entry keeps the nesting readable
+	std::size_t n_first = intervals.size();
+	for (ShadowType type : { ShadowType::penumbra, ShadowType::umbra })
+	{
+		const bool is_umbra = type == ShadowType::umbra;
+		const std::vector<double>& f = is_umbra ? umbra : penumbra;
+		bool in_shadow = f[0] < 0.0;
+		double start_et = et[0];
+		for (std::size_t k = 1; k < n_rows; k++)
+		{
+			if (!in_shadow && f[k] < 0.0)
+			{
+				in_shadow = true;
+				start_et = refine(sc, et, sun, k - 1, is_umbra, f[k - 1], f[k]);
+			}
+			else if (in_shadow && f[k] >= 0.0)
+			{
+				in_shadow = false;
+				intervals.push_back(EclipseInterval{ sc_index, type, start_et, refine(sc, et, sun, k - 1, is_umbra, f[k - 1], f[k]) });
+			}
+		}
+		if (in_shadow) //still in shadow at the end of the history
+		{
+			intervals.push_back(EclipseInterval{ sc_index, type, start_et, et[n_rows - 1] });
+		}
+	}
+	const double direction = (et[n_rows - 1] >= et[0]) ? 1.0 : -1.0;
+	std::stable_sort(intervals.begin() + n_first, intervals.end(), [direction](const EclipseInterval& a, const EclipseInterval& b)
+	{
+		return direction * a.start_et < direction * b.start_et;
+	});
+}
+
+void EclipseAnalyzer::beta_for_plane(const std::vector<Spacecraft>& sats, const std::vector<std::size_t>& members,
+									 const SunTable& sun, std::size_t n_rows, std::vector<double>& beta) const
+{
+	const std::size_t n_pad = simd::padded_size(n_rows);
+	beta.assign(n_rows, 0.0);
+	if (members.empty())
+	{
+		return;
+	}
+
+	//sum of the members' unit orbit normals; the planes of a shell drift together, so the mean is a steadier plane than
+	// any one member's osculating normal
+	thread_local std::vector<double> hx, hy, hz, rx, ry, rz, vx, vy, vz;
+	for (auto* column : { &hx, &hy, &hz })
+	{
+		column->assign(n_pad, 0.0);
+	}
+	for (auto* column : { &rx, &ry, &rz, &vx, &vy, &vz })
+	{
+		column->resize(n_pad);
+	}
+	for (std::size_t i : members)
+	{
+		HistoryArena::ConstBlock cart = sats[i].get_cartesian_history();
+		for (std::size_t k = 0; k < n_pad; k++)
+		{
+			const std::size_t row = std::min(k, n_rows - 1);
+			rx[k] = cart(row, 0);
+			ry[k] = cart(row, 1);
+			rz[k] = cart(row, 2);
+			vx[k] = cart(row, 3);
+			vy[k] = cart(row, 4);
+			vz[k] = cart(row, 5);
+		}
+		for (std::size_t k = 0; k < n_pad; k += simd::WIDTH)
+		{
+			simd::vec px = simd::load(&rx[k]), py = simd::load(&ry[k]), pz = simd::load(&rz[k]);
+			simd::vec qx = simd::load(&vx[k]), qy = simd::load(&vy[k]), qz = simd::load(&vz[k]);
+			simd::vec nx = py * qz - pz * qy, ny = pz * qx - px * qz, nz = px * qy - py * qx;
+			simd::vec inv_h = simd::broadcast(1.0) / simd::sqrt(nx * nx + ny * ny + nz * nz);
+			simd::store(&hx[k], simd::load(&hx[k]) + nx * inv_h);
+			simd::store(&hy[k], simd::load(&hy[k]) + ny * inv_h);
+			simd::store(&hz[k], simd::load(&hz[k]) + nz * inv_h);
+		}
+	}
+
+	//sin(beta) = h_hat . sun_hat; reuses rx as scratch
+	const simd::vec one = simd::broadcast(1.0);
+	const simd::vec minus_one = simd::broadcast(-1.0);
+	for (std::size_t k = 0; k < n_pad; k += simd::WIDTH)
+	{
+		simd::vec nx = simd::load(&hx[k]), ny = simd::load(&hy[k]), nz = simd::load(&hz[k]);
+		simd::vec s = (nx * simd::load(&sun.ux[k]) + ny * simd::load(&sun.uy[k]) + nz * simd::load(&sun.uz[k]))
+			/ simd::sqrt(nx * nx + ny * ny + nz * nz);
+		simd::store(&rx[k], simd::min(simd::max(s, minus_one), one));
+	}
+	for (std::size_t k = 0; k < n_rows; k++)
+	{
+		beta[k] = std::asin(rx[k]);
+	}
+}
+
+double EclipseAnalyzer::refine(const Spacecraft& sc, const std::vector<double>& et, const SunTable& sun, std::size_t row, bool umbra,
+							   double f0, double f1) const
+{
+	const double t0 = et[row];
+	const double dt = et[row + 1] - t0;
+	if (dt == 0.0) //zero-length step (e.g. a burn logged as its own row)
+	{
+		return t0;
+	}
+	const HistoryArena& history = sc.get_history();
+	const Eigen::Vector<double, 6> y0 = history.cart_at(row);
+	const Eigen::Vector<double, 6> y1 = history.cart_at(row + 1);
+	astrokit::DenseStep<Eigen::Vector3d> pos;
+	astrokit::hermite_dense<Eigen::Vector3d>(t0, dt, y0.head<3>(), y0.tail<3>(), y1.head<3>(), y1.tail<3>(), pos);
+
+	//the sun barely moves across an output step; a straight line between the table entries is plenty
+	const Eigen::Vector3d s0(sun.x[row], sun.y[row], sun.z[row]);
+	const Eigen::Vector3d s1(sun.x[row + 1], sun.y[row + 1], sun.z[row + 1]);
+	auto g = [&](double t)
+	{
+		const double theta = (t - t0) / dt;
+		ShadowMargins margins = shadow_margins(pos.evaluate(t), s0 + theta * (s1 - s0));
+		return umbra ? margins.umbra : margins.penumbra;
+	};
+	return astrokit::find_root(g, t0, t0 + dt, f0, f1, this->time_tol);
+}
+#pragma endregion utilities
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+#include "structure_definitions.h"
+#include "Planet.h"
+#include "Spacecraft.h"
+#include "ThreadPool.h"
+
+class EclipseAnalyzer
+{
+public:
+	//shadow & beta angle products for the whole constellation from the propagated histories (power analysis)
+	//conical shadow model: from the spacecraft, the sun's disk has apparent radius a = asin(R_sun / d) and the central
+	// body's has b = asin(R / r), with their centers c apart; it's in penumbra when c < a + b and in umbra when c < b - a.
+	//both tests are done on cosines, so the per-sample work is a few dot products & square roots with no trig; each
+	// spacecraft's whole history is evaluated in SIMD batches of epochs against one shared table of sun positions (looked
+	// up once per epoch, up front). entry/exit times are refined with Brent's method on a cubic Hermite interpolant of the
+	// state and a linear interpolant of the sun, like AccessAnalyzer's rise/set times
+	//beta (sun elevation above the orbit plane) is computed per plane from the members' mean orbit normal
+	//note: every spacecraft has to be on the same output grid (lockstep propagation)
+	//note: spherical central body (mean radius); no atmospheric refraction/dimming
+	//note: a shadow pass shorter than the output step can't be bracketed (only grazing geometry gets anywhere near that)
+	EclipseAnalyzer(Planet& cb);
+	EclipseAnalyzer(Planet& cb, double sun_radius, double time_tol);
+
+	static constexpr int SUN_SPKID = 10;
+	static constexpr double SUN_RADIUS = 695700.0; //[km]; IAU nominal solar radius
+
+	//getters
+	double get_sun_radius() const;
+	double get_time_tol() const;
+
+	//setters
+	void set_sun_radius(double new_sun_radius); //[km]
+	void set_time_tol(double new_time_tol); //[s]; entry/exit times are refined to within this
+
+	//utilities
+	EclipseReport compute(const std::vector<Spacecraft>& sats, const std::vector<std::size_t>& plane_index) const;
+	EclipseReport compute(const std::vector<Spacecraft>& sats, const std::vector<std::size_t>& plane_index, ThreadPool& pool) const;
+	//note: plane_index gives each spacecraft's orbit plane (0, 1, ...; e.g. Constellation::get_orbit_planes); an empty
+	//      list puts every spacecraft in its own plane. the pool splits the spacecraft (then the planes) across threads;
+	//      results don't depend on the thread count
+
+private:
+	struct SunTable //sun position relative to the central body at every output epoch, structure-of-arrays
+	{
+		std::vector<double> x, y, z; //[km]; padded to whole SIMD lanes
+		std::vector<double> ux, uy, uz; //unit vectors (same padding)
+	};
+
+	struct ShadowMargins //cos(c) limits; negative inside the shadow
+	{
+		double penumbra;
+		double umbra;
+	};
+
+	ShadowMargins shadow_margins(const Eigen::Vector3d& r, const Eigen::Vector3d& r_sun) const;
+	void shadow_for_spacecraft(const Spacecraft& sc, std::size_t sc_index, const std::vector<double>& et, const SunTable& sun,
+							   std::vector<EclipseInterval>& intervals) const;
+	void beta_for_plane(const std::vector<Spacecraft>& sats, const std::vector<std::size_t>& members, const SunTable& sun,
+						std::size_t n_rows, std::vector<double>& beta) const;
+	double refine(const Spacecraft& sc, const std::vector<double>& et, const SunTable& sun, std::size_t row, bool umbra,
+				  double f0, double f1) const; //shadow boundary inside [row, row + 1]
+
+	Planet& cb;
+	double sun_radius;
+	double time_tol;
+};
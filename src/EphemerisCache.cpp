@@ -0,0 +1,255 @@
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "EphemerisCache.h"
+#include <astrokit/constants.h>
+#include <astrokit/math_utils.h>
+
+EphemerisCache::EphemerisCache(SpiceHandler& spice, std::vector<int> bodies, int observer_spkid, std::string frame, double et0, double etf) :
+	EphemerisCache(spice, bodies, observer_spkid, frame, et0, etf, 4.0 * 86400.0, 13, 1e-4)
+	//note: 4 day segments of degree 13 are what the JPL ephemerides use for the Moon; the Sun fits far more easily
+{
+}
+
+EphemerisCache::EphemerisCache(SpiceHandler& spice, std::vector<int> bodies, int observer_spkid, std::string frame, double et0, double etf,
+							   double segment_length, int degree, double max_error) :
+	spice(spice), observer(observer_spkid), frame(frame), et0(et0), etf(etf), degree(degree), max_error(max_error)
+{
+	if (etf <= et0 || segment_length <= 0.0 || degree < 2 || max_error <= 0.0)
+	{
+		throw std::runtime_error("EphemerisCache needs et0 < etf, a positive segment length, degree >= 2, and a positive error bound.");
+	}
+
+	const double min_segment = 3600.0; //[s]; anything needing shorter segments than this is a bad bound/degree pairing
+	for (int body : bodies)
+	{
+		BodyTable table{};
+		table.spkid = body;
+		double length = std::min(segment_length, etf - et0);
+		fit(table, length);
+		table.achieved_error = fit_error(table);
+		while (table.achieved_error > max_error && table.segment_length > min_segment)
+		{
+			fit(table, std::max(0.5 * table.segment_length, min_segment));
+			table.achieved_error = fit_error(table);
+		}
+		if (table.achieved_error > max_error)
+		{
+			throw std::runtime_error("EphemerisCache couldn't fit body " + std::to_string(body) + " to the requested accuracy.");
+		}
+		this->tables.push_back(std::move(table));
+	}
+	//whatever replaces or adds this cache (e.g. Planet::cache_ephemeris) now answers position lookups differently
+	SpiceHandler::bump_ephemeris_generation();
+}
+
+#pragma region getters
+int EphemerisCache::get_observer() const
+{
+	return this->observer;
+}
+
+std::string EphemerisCache::get_frame() const
+{
+	return this->frame;
+}
+
+double EphemerisCache::get_et0() const
+{
+	return this->et0;
+}
+
+double EphemerisCache::get_etf() const
+{
+	return this->etf;
+}
+
+std::vector<int> EphemerisCache::get_bodies() const
+{
+	std::vector<int> bodies;
+	for (const auto& table : this->tables)
+	{
+		bodies.push_back(table.spkid);
+	}
+	return bodies;
+}
+
+double EphemerisCache::get_segment_length(int body) const
+{
+	return this->tables[body_index(body)].segment_length;
+}
+
+double EphemerisCache::get_achieved_error(int body) const
+{
+	return this->tables[body_index(body)].achieved_error;
+}
+#pragma endregion getters
+
+#pragma region utilities
+bool EphemerisCache::covers(double et) const
+{
+	return et >= this->et0 && et <= this->etf;
+}
+
+bool EphemerisCache::has_body(int body) const
+{
+	return std::any_of(this->tables.begin(), this->tables.end(), [body](const BodyTable& table) { return table.spkid == body; });
+}
+
+std::size_t EphemerisCache::body_index(int body) const
+{
+	for (std::size_t i = 0; i < this->tables.size(); i++)
+	{
+		if (this->tables[i].spkid == body)
+		{
+			return i;
+		}
+	}
+	throw std::runtime_error("Body " + std::to_string(body) + " isn't in the ephemeris cache.");
+}
+
+Eigen::Vector3d EphemerisCache::position(int body, double et) const
+{
+	return position(body_index(body), et);
+}
+
+Eigen::Vector3d EphemerisCache::position(std::size_t body_ix, double et) const
+{
+	Eigen::Vector3d pos;
+	evaluate(this->tables[body_ix], et, &pos, nullptr);
+	return pos;
+}
+
+std::array<Eigen::Vector3d, 2> EphemerisCache::state(int body, double et) const
+{
+	return state(body_index(body), et);
+}
+
+std::array<Eigen::Vector3d, 2> EphemerisCache::state(std::size_t body_ix, double et) const
+{
+	std::array<Eigen::Vector3d, 2> pos_vel;
+	evaluate(this->tables[body_ix], et, &pos_vel[0], &pos_vel[1]);
+	return pos_vel;
+}
+
+void EphemerisCache::positions(int body, const std::vector<double>& ets, std::vector<Eigen::Vector3d>& out) const
+{
+	const BodyTable& table = this->tables[body_index(body)];
+	out.resize(ets.size());
+	for (std::size_t k = 0; k < ets.size(); k++)
+	{
+		evaluate(table, ets[k], &out[k], nullptr);
+	}
+}
+
+double EphemerisCache::check_accuracy(int body, std::size_t n_samples)
+{
+	const BodyTable& table = this->tables[body_index(body)];
+	double worst = 0.0;
+	for (std::size_t k = 0; k < n_samples; k++)
+	{
+		double et = astrokit::random_double(this->et0, this->etf);
+		Eigen::Vector3d pos;
+		evaluate(table, et, &pos, nullptr);
+		worst = std::max(worst, (pos - this->spice.fetch_pos(et, body, this->observer, this->frame)).norm());
+	}
+	return worst;
+}
+
+void EphemerisCache::fit(BodyTable& table, double segment_length)
+{
+	//interpolate each axis at the n Chebyshev nodes of the segment; the coefficients then come from the discrete
+	// orthogonality of the cosines: c_j = (2 / n) * sum_k f(x_k) * cos(pi * j * (k + 0.5) / n), with c_0 halved
+	const int n = this->degree + 1;
+	table.segment_length = segment_length;
+	table.n_segments = static_cast<std::size_t>(std::ceil((this->etf - this->et0) / segment_length));
+	table.coeffs.assign(table.n_segments * 3 * n, 0.0);
+
+	std::vector<Eigen::Vector3d> samples(n);
+	for (std::size_t s = 0; s < table.n_segments; s++)
+	{
+		const double half = 0.5 * segment_length;
+		const double mid = this->et0 + s * segment_length + half;
+		for (int k = 0; k < n; k++)
+		{
+			double x = std::cos(astrokit::PI * (k + 0.5) / n);
+			samples[k] = this->spice.fetch_pos(mid + half * x, table.spkid, this->observer, this->frame);
+		}
+
+		double* c = &table.coeffs[s * 3 * n];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			for (int j = 0; j < n; j++)
+			{
+				double sum = 0.0;
+				for (int k = 0; k < n; k++)
+				{
+					sum += samples[k][axis] * std::cos(astrokit::PI * j * (k + 0.5) / n);
+				}
+				c[axis * n + j] = (j == 0 ? 1.0 : 2.0) * sum / n;
+			}
+		}
+	}
+}
+
+double EphemerisCache::fit_error(const BodyTable& table)
+{
+	//an interpolant is exact at its nodes, so check halfway between them (and at the segment ends)
+	const int n = this->degree + 1;
+	double worst = 0.0;
+	for (std::size_t s = 0; s < table.n_segments; s++)
+	{
+		const double half = 0.5 * table.segment_length;
+		const double mid = this->et0 + s * table.segment_length + half;
+		for (int k = 0; k <= n; k++)
+		{
+			double x = std::cos(astrokit::PI * k / n);
+			double et = std::clamp(mid + half * x, this->et0, this->etf);
+			Eigen::Vector3d pos;
+			evaluate(table, et, &pos, nullptr);
+			worst = std::max(worst, (pos - this->spice.fetch_pos(et, table.spkid, this->observer, this->frame)).norm());
+		}
+	}
+	return worst;
+}
+
+void EphemerisCache::evaluate(const BodyTable& table, double et, Eigen::Vector3d* pos, Eigen::Vector3d* vel) const
+{
+	if (!covers(et))
+	{
+		throw std::runtime_error("Epoch outside of the ephemeris cache span.");
+	}
+	const int n = this->degree + 1;
+	std::size_t s = std::min(static_cast<std::size_t>((et - this->et0) / table.segment_length), table.n_segments - 1);
+	const double half = 0.5 * table.segment_length;
+	const double x = (et - (this->et0 + s * table.segment_length + half)) / half;
+	const double* c = &table.coeffs[s * 3 * n];
+
+	//T_j(x) & T_j'(x) by their three-term recurrences, summed for all three axes in the same pass
+	double t_prev = 1.0, t_cur = x; //T_0, T_1
+	double dt_prev = 0.0, dt_cur = 1.0; //T_0', T_1'
+	Eigen::Vector3d p(c[0], c[n], c[2 * n]);
+	Eigen::Vector3d v(0.0, 0.0, 0.0);
+	for (int j = 1; j < n; j++)
+	{
+		p += t_cur * Eigen::Vector3d(c[j], c[n + j], c[2 * n + j]);
+		v += dt_cur * Eigen::Vector3d(c[j], c[n + j], c[2 * n + j]);
+
+		double t_next = 2.0 * x * t_cur - t_prev;
+		double dt_next = 2.0 * t_cur + 2.0 * x * dt_cur - dt_prev;
+		t_prev = t_cur;
+		t_cur = t_next;
+		dt_prev = dt_cur;
+		dt_cur = dt_next;
+	}
+
+	if (pos)
+	{
+		*pos = p;
+	}
+	if (vel)
+	{
+		*vel = v / half; //chain rule for x = (et - mid) / half
+	}
+}
+#pragma endregion utilities
@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <array>
+#include <Eigen/Dense>
+#include "SpiceHandler.h"
+
+class EphemerisCache
+{
+public:
+	//Chebyshev fits of body positions over a fixed time span (same idea as an SPK type 2 segment)
+	//each body gets uniform segments with one Chebyshev series per axis, fit at the Chebyshev nodes of the segment from
+	// SPICE once at startup; positions & velocities (derivative of the series) are then evaluated without touching SPICE.
+	//segments are checked against spkez_c at points between the fit nodes and halved until the position error is within
+	// max_error; after construction the cache is immutable, so any number of threads can query it at once
+	//building one bumps SpiceHandler::ephemeris_generation, since it changes what Planet::body_position returns
+	//note: every body is relative to the same observer & frame (e.g. Sun & Moon relative to Earth in J2000)
+	EphemerisCache(SpiceHandler& spice, std::vector<int> bodies, int observer_spkid, std::string frame, double et0, double etf);
+	EphemerisCache(SpiceHandler& spice, std::vector<int> bodies, int observer_spkid, std::string frame, double et0, double etf,
+				   double segment_length, int degree, double max_error);
+
+	//don't want copies of the tables floating around
+	EphemerisCache(const EphemerisCache&) = delete;
+	EphemerisCache& operator=(const EphemerisCache&) = delete;
+	EphemerisCache(EphemerisCache&&) = delete;
+	EphemerisCache& operator=(EphemerisCache&&) = delete;
+
+	//getters
+	int get_observer() const;
+	std::string get_frame() const;
+	double get_et0() const;
+	double get_etf() const;
+	std::vector<int> get_bodies() const;
+	double get_segment_length(int body) const; //final segment length after refinement [s]
+	double get_achieved_error(int body) const; //largest position error found during the fit check [km]
+
+	//utilities
+	bool covers(double et) const;
+	bool has_body(int body) const;
+	std::size_t body_index(int body) const; //resolve once, then use the index overloads in hot loops
+
+	Eigen::Vector3d position(int body, double et) const;
+	Eigen::Vector3d position(std::size_t body_ix, double et) const;
+	std::array<Eigen::Vector3d, 2> state(int body, double et) const; //position & velocity
+	std::array<Eigen::Vector3d, 2> state(std::size_t body_ix, double et) const;
+	void positions(int body, const std::vector<double>& ets, std::vector<Eigen::Vector3d>& out) const; //batch version
+
+	double check_accuracy(int body, std::size_t n_samples); //max position error vs spkez_c at n_samples random epochs [km]
+
+private:
+	struct BodyTable
+	{
+		int spkid;
+		double segment_length;
+		double achieved_error;
+		std::size_t n_segments;
+		std::vector<double> coeffs; //per segment: x coefficients, then y, then z (degree + 1 each)
+	};
+
+	void fit(BodyTable& table, double segment_length);
+	double fit_error(const BodyTable& table);
+	void evaluate(const BodyTable& table, double et, Eigen::Vector3d* pos, Eigen::Vector3d* vel) const;
+
+	SpiceHandler& spice;
+	int observer;
+	std::string frame;
+	double et0;
+	double etf;
+	int degree;
+	double max_error;
+
+	std::vector<BodyTable> tables;
+};
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "EventDetector.h"
+#include <astrokit/math_utils.h>
+#include <astrokit/integrators.h>
+
+EventDetector::EventDetector() : events(), scans(), logs(), time_tol(1e-3)
+{
+}
+
+EventDetector::EventDetector(double time_tol) : events(), scans(), logs()
+{
+	set_time_tol(time_tol);
+}
+
+#pragma region getters
+double EventDetector::get_time_tol() const
+{
+	return this->time_tol;
+}
+
+std::size_t EventDetector::get_event_count() const
+{
+	return this->events.size();
+}
+
+const EventDefinition& EventDetector::get_event(std::size_t event_index) const
+{
+	if (event_index >= this->events.size())
+	{
+		throw std::runtime_error("Event index out of range.");
+	}
+	return this->events[event_index];
+}
+
+const std::vector<EventRecord>& EventDetector::get_log(std::size_t sc_index) const
+{
+	static const std::vector<EventRecord> no_events;
+	return (sc_index < this->logs.size()) ? this->logs[sc_index] : no_events;
+}
+#pragma endregion getters
+
+#pragma region setters
+void EventDetector::set_time_tol(double new_time_tol)
+{
+	if (new_time_tol <= 0.0)
+	{
+		throw std::runtime_error("Event time tolerance must be positive.");
+	}
+	this->time_tol = new_time_tol;
+}
+#pragma endregion setters
+
+#pragma region utilities
+std::size_t EventDetector::add_event(EventDefinition event)
+{
+	if (!event.g)
+	{
+		throw std::runtime_error("Event " + event.name + " needs an event function.");
+	}
+	this->events.push_back(std::move(event));
+	restart_scans(); //every g has to be evaluated at the row the scan restarts from
+	return this->events.size() - 1;
+}
+
+void EventDetector::clear_events()
+{
+	this->events.clear();
+	this->scans.clear();
+	this->logs.clear();
+}
+
+void EventDetector::clear_logs()
+{
+	for (auto& log : this->logs)
+	{
+		log.clear();
+	}
+}
+
+void EventDetector::detect(const std::vector<Spacecraft>& sats, double mu, ThreadPool& pool)
+{
+	if (this->events.empty())
+	{
+		return;
+	}
+	this->scans.resize(sats.size());
+	this->logs.resize(sats.size());
+
+	std::vector<std::vector<EventRecord>> found(sats.size());
+	pool.parallel_for(sats.size(), [&](std::size_t i0, std::size_t i1)
+	{
+		for (std::size_t i = i0; i < i1; i++)
+		{
+			scan_spacecraft(sats[i], i, mu, this->scans[i], found[i]);
+		}
+	});
+
+	//deliver serially so the logs & callbacks see the same order for any thread count
+	for (std::size_t i = 0; i < sats.size(); i++)
+	{
+		for (const EventRecord& record : found[i])
+		{
+			const EventDefinition& event = this->events[record.event_index];
+			if (event.log)
+			{
+				this->logs[i].push_back(record);
+			}
+			if (event.callback)
+			{
+				event.callback(record);
+			}
+		}
+	}
+}
+
+EventFunction EventDetector::node_crossing()
+{
+	return [](std::size_t, double, const Eigen::Vector<double, 6>& state) { return state[2]; };
+}
+
+EventFunction EventDetector::radius_crossing(double radius)
+{
+	return [radius](std::size_t, double, const Eigen::Vector<double, 6>& state) { return state.head<3>().norm() - radius; };
+}
+
+void EventDetector::scan_spacecraft(const Spacecraft& sc, std::size_t sc_index, double mu, Scan& scan,
+									std::vector<EventRecord>& found) const
+{
+	const HistoryArena& history = sc.get_history();
+	const std::size_t n_rows = history.get_rows();
+	if (n_rows == 0)
+	{
+		return;
+	}
+	const std::size_t first_row = history.get_first_row();
+	const std::size_t last_row = first_row + n_rows - 1;
+	const std::size_t n_events = this->events.size();
+
+	auto g_at = [&](std::size_t e, double et, const Eigen::Vector<double, 6>& state)
+	{
+		return this->events[e].g(sc_index, et, state);
+	};
+
+	//first call, or the history was reset/trimmed out from under us: start over from the newest row
+	if (!scan.started || scan.next_row > last_row || scan.next_row < first_row)
+	{
+		const std::size_t row = n_rows - 1;
+		const Eigen::Vector<double, 6> state = history.cart_at(row);
+		scan.g_prev.resize(n_events);
+		for (std::size_t e = 0; e < n_events; e++)
+		{
+			scan.g_prev[e] = g_at(e, history.et_at(row), state);
+		}
+		scan.next_row = last_row;
+		scan.started = true;
+		return;
+	}
+
+	//time derivative of the cartesian state for the interpolant; point mass is plenty for the velocity's shape across one step
+	auto derivative = [mu](const Eigen::Vector<double, 6>& state)
+	{
+		const Eigen::Vector3d r = state.head<3>();
+		const double r_mag = r.norm();
+		Eigen::Vector<double, 6> f;
+		f << state.tail<3>(), -mu / (r_mag * r_mag * r_mag) * r;
+		return f;
+	};
+
+	std::vector<double> g_next(n_events);
+	for (std::size_t row = scan.next_row - first_row; row + 1 < n_rows; row++)
+	{
+		const double t0 = history.et_at(row);
+		const double t1 = history.et_at(row + 1);
+		const Eigen::Vector<double, 6> y0 = history.cart_at(row);
+		const Eigen::Vector<double, 6> y1 = history.cart_at(row + 1);
+
+		const std::size_t n_found = found.size();
+		bool have_dense = false;
+		astrokit::DenseStep<Eigen::Vector<double, 6>> dense;
+		for (std::size_t e = 0; e < n_events; e++)
+		{
+			g_next[e] = g_at(e, t1, y1);
+			const double g0 = scan.g_prev[e];
+			const double g1 = g_next[e];
+			if ((g0 < 0.0) == (g1 < 0.0))
+			{
+				continue;
+			}
+			const bool rising = g1 >= 0.0;
+			const EventDirection direction = this->events[e].direction;
+			if ((direction == EventDirection::rising && !rising) || (direction == EventDirection::falling && rising))
+			{
+				continue;
+			}
+
+			if (t1 == t0) //zero-length step (e.g. a burn logged as its own row); the event is at the step
+			{
+				found.push_back(EventRecord{ sc_index, e, t1, rising, y1 });
+				continue;
+			}
+			if (!have_dense)
+			{
+				astrokit::hermite_dense<Eigen::Vector<double, 6>>(t0, t1 - t0, y0, derivative(y0), y1, derivative(y1), dense);
+				have_dense = true;
+			}
+			auto g = [&](double t) { return g_at(e, t, dense.evaluate(t)); };
+			const double et = astrokit::find_root(g, t0, t1, g0, g1, this->time_tol);
+			found.push_back(EventRecord{ sc_index, e, et, rising, dense.evaluate(et) });
+		}
+
+		//several events inside one step come out in time order (ties keep the event order)
+		const double direction = (t1 >= t0) ? 1.0 : -1.0;
+		std::stable_sort(found.begin() + n_found, found.end(), [direction](const EventRecord& a, const EventRecord& b)
+		{
+			return direction * a.et < direction * b.et;
+		});
+		scan.g_prev.swap(g_next);
+	}
+	scan.next_row = last_row;
+}
+
+void EventDetector::restart_scans()
+{
+	for (Scan& scan : this->scans)
+	{
+		scan.started = false;
+	}
+}
+#pragma endregion utilities
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <functional>
+#include <Eigen/Dense>
+#include "structure_definitions.h"
+#include "Spacecraft.h"
+#include "ThreadPool.h"
+
+//g(sc_index, et, icrf cartesian state); an event happens wherever g changes sign
+using EventFunction = std::function<double(std::size_t, double, const Eigen::Vector<double, 6>&)>;
+using EventCallback = std::function<void(const EventRecord&)>;
+
+struct EventDefinition
+{
+	std::string name;
+	EventFunction g;
+	EventDirection direction = EventDirection::any;
+	EventCallback callback = nullptr; //optional; runs for every event found
+	bool log = true; //keep the events in the per-spacecraft logs too
+};
+
+class EventDetector
+{
+public:
+	//generic event location on the propagated trajectories; the constellation calls detect after every output step
+	// (stepping modes) or every chunk of output rows (closed-form modes)
+	//each registered g is evaluated once per new history row; a sign change between two rows brackets a root, which gets
+	// refined with Brent's method on the step's cubic Hermite interpolant (positions from the stored velocities, velocities
+	// from point-mass accelerations at both ends), so nothing is re-integrated
+	//note: the spacecraft are scanned in parallel, so g has to be safe to call from several threads at once (no SPICE
+	//      calls; use Planet's caches or precomputed data). callbacks always run afterwards on the calling thread, in
+	//      spacecraft order & then time order, so the order they see doesn't depend on the thread count
+	//note: two roots inside one output step cancel out & can't be bracketed; keep the output step well below the shortest
+	//      interval between events you care about
+	//note: impulsive burns (station keeping) are logged as zero-length rows holding the post-burn state, so no step's
+	//      interpolant straddles a velocity jump; a sign change across one of those rows is reported at the burn epoch
+	EventDetector();
+	EventDetector(double time_tol);
+
+	//getters
+	double get_time_tol() const;
+	std::size_t get_event_count() const;
+	const EventDefinition& get_event(std::size_t event_index) const;
+	const std::vector<EventRecord>& get_log(std::size_t sc_index) const; //logged events for one spacecraft, in time order
+
+	//setters
+	void set_time_tol(double new_time_tol); //[s]; event times are refined to within this
+
+	//utilities
+	std::size_t add_event(EventDefinition event); //returns the event's index (EventRecord::event_index)
+	//note: an event added part way through a propagation starts looking from each spacecraft's newest history row
+	void clear_events(); //also clears the logs
+	void clear_logs();
+	void detect(const std::vector<Spacecraft>& sats, double mu, ThreadPool& pool); //scans every history row added since the last call
+
+	//common event functions
+	static EventFunction node_crossing(); //z; rising at the ascending node
+	static EventFunction radius_crossing(double radius); //|r| - radius; rising on the way up through radius [km]
+
+private:
+	struct Scan //per-spacecraft progress through its history
+	{
+		std::size_t next_row = 0; //overall row number (see HistoryArena::get_first_row) of the last row scanned
+		bool started = false;
+		std::vector<double> g_prev; //each g at next_row
+	};
+
+	void scan_spacecraft(const Spacecraft& sc, std::size_t sc_index, double mu, Scan& scan, std::vector<EventRecord>& found) const;
+	void restart_scans(); //next detect picks up from the newest rows
+
+	std::vector<EventDefinition> events;
+	std::vector<Scan> scans;
+	std::vector<std::vector<EventRecord>> logs;
+	double time_tol;
+};
@@ -1,33 +1,107 @@
+#include <stdexcept>
 #include "ForceModel.h"
 
-ForceModel::ForceModel(Planet& cb) : cb(cb), include_j2(true)
+ForceModel::ForceModel(Planet& cb) : cb(cb), include_j2(true), gravity_degree(0), gravity_order(0)
 {
 }
 
-ForceModel::ForceModel(Planet& cb, bool include_j2) : cb(cb)
+ForceModel::ForceModel(Planet& cb, bool include_j2) : cb(cb), gravity_degree(0), gravity_order(0)
 {
 	set_include_j2(include_j2);
 }
 
+const Planet& ForceModel::get_cb() const
+{
+	return this->cb;
+}
+
+bool ForceModel::get_include_j2() const
+{
+	return this->include_j2;
+}
+
+int ForceModel::get_gravity_degree() const
+{
+	return this->gravity_degree;
+}
+
+int ForceModel::get_gravity_order() const
+{
+	return this->gravity_order;
+}
+
+const std::vector<PerturbingBody>& ForceModel::get_third_bodies() const
+{
+	return this->third_bodies;
+}
+
 void ForceModel::set_include_j2(bool j2_included)
 {
 	this->include_j2 = j2_included;
 }
 
-Eigen::Vector<double, 6> ForceModel::eoms(double, const Eigen::Vector<double, 6>& state)
+void ForceModel::set_gravity_degree(int degree, int order)
 {
-	Eigen::Vector<double, 6> dstate_dt_kep = astrokit::accel_kep(state, cb.get_mu());
-	Eigen::Vector<double, 6> dstate_dt_j2 = astrokit::accel_j2(state, cb.get_mu(), cb.get_eq_radius(), cb.get_j2());
-	//note: only want the accel components from accel_j2
+	if (degree == 0)
+	{
+		this->gravity_degree = 0;
+		this->gravity_order = 0;
+		return;
+	}
+	const GravityField* field = this->cb.get_gravity_field();
+	if (!field)
+	{
+		throw std::runtime_error("The central body has no gravity field loaded (Planet::load_gravity_field).");
+	}
+	if (degree < 2 || degree > field->get_max_degree() || order < 0 || order > degree)
+	{
+		throw std::runtime_error("Gravity degree/order must satisfy 2 <= degree <= " + std::to_string(field->get_max_degree()) +
+								 " and 0 <= order <= degree.");
+	}
+	this->gravity_degree = degree;
+	this->gravity_order = order;
+}
 
-	Eigen::Vector3d vel = dstate_dt_kep.segment<3>(0);
-	Eigen::Vector3d accel = dstate_dt_kep.segment<3>(3);
-	if (this->include_j2)
+void ForceModel::add_third_body(int spkid, double mu)
+{
+	if (spkid == this->cb.get_spkid() || mu <= 0.0)
+	{
+		throw std::runtime_error("A third body needs a positive mu and can't be the central body.");
+	}
+	for (const PerturbingBody& body : this->third_bodies)
 	{
-		accel += dstate_dt_j2.segment<3>(3);
+		if (body.spkid == spkid)
+		{
+			throw std::runtime_error("Body " + std::to_string(spkid) + " is already in the force model.");
+		}
 	}
-	Eigen::Vector<double, 6> dstate_dt;
-	dstate_dt << vel, accel;
+	this->third_bodies.push_back({ spkid, mu });
+}
 
-	return dstate_dt;
+void ForceModel::clear_third_bodies()
+{
+	this->third_bodies.clear();
+}
+
+bool ForceModel::is_two_body() const
+{
+	return !this->include_j2 && this->gravity_degree == 0 && this->third_bodies.empty();
+}
+
+const GravityField& ForceModel::harmonic_field() const
+{
+	const GravityField* field = this->cb.get_gravity_field();
+	if (!field)
+	{
+		throw std::runtime_error("The central body has no gravity field loaded (Planet::load_gravity_field).");
+	}
+	return *field;
+}
+
+Eigen::Vector<double, 6> ForceModel::eoms(double t, const Eigen::Vector<double, 6>& state)
+{
+	return with_kernel([&](const auto& kernel)
+	{
+		return kernel(t, state);
+	});
 }
@@ -1,6 +1,9 @@
 #pragma once
 
-#include "Planet.h"	
+#include <vector>
+#include "Planet.h"
+#include "ThirdBodyTerm.h"
+#include "structure_definitions.h"
 #include <astrokit/force_models.h>
 #include <astrokit/integrators.h>
 
@@ -9,7 +12,8 @@ class ForceModel
 public:
 	//normally I'd break integration up into it's own class but for simplicity's sake I'm just defining both the EOMs and 
 	// integration step function here.
-	//note: NOT set up for n-body perturbations as is; sticking with J2 only for this demo
+	//note: J2 by default, or the planet's spherical harmonic field up to a chosen degree/order (set_gravity_degree),
+	//      plus optional point-mass third bodies (add_third_body)
 	ForceModel(Planet& cb);
 	ForceModel(Planet& cb, bool include_j2);
 
@@ -19,14 +23,66 @@ public:
 	ForceModel(ForceModel&&) = delete;
 	ForceModel& operator=(ForceModel&&) = delete;
 
+	//getters
+	const Planet& get_cb() const;
+	bool get_include_j2() const;
+	int get_gravity_degree() const;
+	int get_gravity_order() const;
+	const std::vector<PerturbingBody>& get_third_bodies() const;
+	bool is_two_body() const; //true when nothing but point-mass gravity is modeled (closed-form propagation applies)
+
+	//setters
 	void set_include_j2(bool j2_included);
+	void set_gravity_degree(int degree, int order);
+	//note: degree >= 2 uses the planet's loaded GravityField truncated to degree/order in place of the J2 term
+	//      (include_j2 is then ignored); degree 0 goes back to J2 only. cost grows roughly with degree * order
+	void add_third_body(int spkid, double mu); //point-mass perturber, e.g. (10, astrokit::MU_SUN_km3_s2) or (301, 4902.8)
+	void clear_third_bodies();
+	//note: cache the bodies on the planet (Planet::cache_ephemeris) for the propagation span; outside the cache every
+	//      stage epoch costs a (locked) SPICE call per body per thread
 
 	Eigen::Vector<double, 6> eoms(double t, const Eigen::Vector<double, 6>& state);
+	//note: convenience wrapper around with_kernel; integrators should grab the kernel once per step instead
+
+	template <typename F>
+	auto with_kernel(F&& f) const
+	//calls f(kernel) with the fused gravity kernel for the current settings (see astrokit/force_models.h); the flags are
+	// resolved here, once, so the kernel evaluated in every integrator stage is branch-free
+	{
+		if (this->third_bodies.empty())
+		{
+			return with_gravity_kernel(f);
+		}
+		return with_gravity_kernel(f, ThirdBodyTerm(this->cb, this->third_bodies));
+	}
 
 
 private:
+	template <typename F, typename... Extra>
+	auto with_gravity_kernel(F& f, const Extra&... extra) const
+	//central body terms (Kepler + J2 or the spherical harmonic field), followed by any extra terms
+	{
+		const double mu = this->cb.get_mu();
+		if (this->gravity_degree >= 2)
+		{
+			SphericalHarmonicTerm harmonics(harmonic_field(), this->cb, this->gravity_degree, this->gravity_order);
+			return f(astrokit::FusedGravity<astrokit::KeplerTerm, SphericalHarmonicTerm, Extra...>(astrokit::KeplerTerm(mu), harmonics, extra...));
+		}
+		if (this->include_j2)
+		{
+			astrokit::J2Term j2(mu, this->cb.get_eq_radius(), this->cb.get_j2());
+			return f(astrokit::FusedGravity<astrokit::KeplerTerm, astrokit::J2Term, Extra...>(astrokit::KeplerTerm(mu), j2, extra...));
+		}
+		return f(astrokit::FusedGravity<astrokit::KeplerTerm, Extra...>(astrokit::KeplerTerm(mu), extra...));
+	}
+
+	const GravityField& harmonic_field() const; //the planet's current field (reloading it with a lower degree just truncates further)
+
 	Planet& cb; //central body;
 
 	bool include_j2;
+	int gravity_degree; //0 = J2 only (per include_j2)
+	int gravity_order;
+	std::vector<PerturbingBody> third_bodies; //point-mass perturbers (empty = none)
 
 };
@@ -0,0 +1,325 @@
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "GravityField.h"
+#include "Planet.h"
+
+GravityField::GravityField(std::string file_name, int max_degree) :
+	mu(0.0), radius(0.0), max_degree(max_degree)
+{
+	if (max_degree < 2)
+	{
+		throw std::runtime_error("GravityField needs max_degree >= 2.");
+	}
+	load(file_name, true);
+	build_tables();
+}
+
+GravityField::GravityField(std::string file_name, int max_degree, double mu, double radius) :
+	mu(mu), radius(radius), max_degree(max_degree)
+{
+	if (max_degree < 2 || mu <= 0.0 || radius <= 0.0)
+	{
+		throw std::runtime_error("GravityField needs max_degree >= 2 and a positive mu & radius.");
+	}
+	load(file_name, false);
+	//note: the values passed in win over anything in a header
+	this->mu = mu;
+	this->radius = radius;
+	build_tables();
+}
+
+GravityField::GravityField(double mu, double radius, int max_degree) :
+	mu(mu), radius(radius), max_degree(max_degree)
+{
+	if (max_degree < 2 || mu <= 0.0 || radius <= 0.0)
+	{
+		throw std::runtime_error("GravityField needs max_degree >= 2 and a positive mu & radius.");
+	}
+	this->C.assign(idx(this->max_degree + 1, 0), 0.0);
+	this->S.assign(idx(this->max_degree + 1, 0), 0.0);
+	build_tables();
+}
+
+#pragma region getters
+double GravityField::get_mu() const
+{
+	return this->mu;
+}
+
+double GravityField::get_radius() const
+{
+	return this->radius;
+}
+
+int GravityField::get_max_degree() const
+{
+	return this->max_degree;
+}
+
+double GravityField::get_C(int n, int m) const
+{
+	return (n <= this->max_degree && m >= 0 && m <= n) ? this->C[idx(n, m)] : 0.0;
+}
+
+double GravityField::get_S(int n, int m) const
+{
+	return (n <= this->max_degree && m >= 0 && m <= n) ? this->S[idx(n, m)] : 0.0;
+}
+#pragma endregion getters
+
+#pragma region setters
+void GravityField::set_coefficients(int n, int m, double C, double S)
+{
+	if (n < 0 || n > this->max_degree || m < 0 || m > n)
+	{
+		throw std::runtime_error("Gravity coefficient (" + std::to_string(n) + ", " + std::to_string(m) + ") is outside the field.");
+	}
+	this->C[idx(n, m)] = C;
+	this->S[idx(n, m)] = S;
+}
+#pragma endregion setters
+
+#pragma region utilities
+Eigen::Vector3d GravityField::accel(const Eigen::Vector3d& r_bcf, int degree, int order) const
+{
+	//normalized Cunningham recursion (Montenbruck & Gill, Satellite Orbits, 3.2.4, with the V/W terms scaled by the
+	// same factors as the coefficients so C * V stays O(1) at any degree)
+	const int N = std::min(degree, this->max_degree);
+	const int M = std::min(order, N);
+	if (N < 2)
+	{
+		return Eigen::Vector3d::Zero();
+	}
+
+	//V/W are needed to degree N + 1 and order M + 1; the scratch table only ever grows, so after the first call on a
+	// thread there are no allocations
+	thread_local std::vector<double> V;
+	thread_local std::vector<double> W;
+	const std::size_t n_terms = idx(N + 2, 0);
+	if (V.size() < n_terms)
+	{
+		V.resize(n_terms);
+		W.resize(n_terms);
+	}
+
+	const double r2 = r_bcf.squaredNorm();
+	const double x0 = this->radius * r_bcf(0) / r2;
+	const double y0 = this->radius * r_bcf(1) / r2;
+	const double z0 = this->radius * r_bcf(2) / r2;
+	const double rho = this->radius * this->radius / r2;
+
+	V[0] = this->radius / std::sqrt(r2);
+	W[0] = 0.0;
+	for (int n = 1; n <= N + 1; n++)
+	{
+		//row n from rows n - 1 & n - 2: zonal/tesseral terms first, then the two entries next to the diagonal
+		const int m_max = std::min(n, M + 1);
+		double* Vn = V.data() + idx(n, 0);
+		double* Wn = W.data() + idx(n, 0);
+		const double* V1 = V.data() + idx(n - 1, 0);
+		const double* W1 = W.data() + idx(n - 1, 0);
+		const double* a = this->a_nm.data() + idx(n, 0);
+		if (n >= 2)
+		{
+			const double* V2 = V.data() + idx(n - 2, 0);
+			const double* W2 = W.data() + idx(n - 2, 0);
+			const double* b = this->b_nm.data() + idx(n, 0);
+			const int m_end = std::min(n - 2, m_max);
+			for (int m = 0; m <= m_end; m++)
+			{
+				Vn[m] = a[m] * z0 * V1[m] - b[m] * rho * V2[m];
+				Wn[m] = a[m] * z0 * W1[m] - b[m] * rho * W2[m];
+			}
+		}
+		if (n - 1 <= m_max)
+		{
+			Vn[n - 1] = a[n - 1] * z0 * V1[n - 1];
+			Wn[n - 1] = a[n - 1] * z0 * W1[n - 1];
+		}
+		if (n <= m_max)
+		{
+			Vn[n] = this->diag[n] * (x0 * V1[n - 1] - y0 * W1[n - 1]);
+			Wn[n] = this->diag[n] * (x0 * W1[n - 1] + y0 * V1[n - 1]);
+		}
+	}
+
+	//coefficient (n, m) pairs with V/W(n + 1, m - 1..m + 1), so each degree reads three neighbours in the next row
+	double ax = 0.0, ay = 0.0, az = 0.0;
+	for (int n = 2; n <= N; n++)
+	{
+		const std::size_t k0 = idx(n, 0);
+		const double* Cn = this->C.data() + k0;
+		const double* Sn = this->S.data() + k0;
+		const double* f_up = this->f_xy_up.data() + k0;
+		const double* f_down = this->f_xy_down.data() + k0;
+		const double* f_mid = this->f_z.data() + k0;
+		const double* Vr = V.data() + idx(n + 1, 0);
+		const double* Wr = W.data() + idx(n + 1, 0);
+
+		double sx = -f_up[0] * Cn[0] * Vr[1];
+		double sy = -f_up[0] * Cn[0] * Wr[1];
+		double sz = -f_mid[0] * Cn[0] * Vr[0];
+		const int m_max = std::min(n, M);
+		for (int m = 1; m <= m_max; m++)
+		{
+			const double Cnm = Cn[m];
+			const double Snm = Sn[m];
+			sx += f_up[m] * (-Cnm * Vr[m + 1] - Snm * Wr[m + 1]) + f_down[m] * (Cnm * Vr[m - 1] + Snm * Wr[m - 1]);
+			sy += f_up[m] * (-Cnm * Wr[m + 1] + Snm * Vr[m + 1]) + f_down[m] * (-Cnm * Wr[m - 1] + Snm * Vr[m - 1]);
+			sz -= f_mid[m] * (Cnm * Vr[m] + Snm * Wr[m]);
+		}
+		ax += sx;
+		ay += sy;
+		az += sz;
+	}
+
+	const double scale = this->mu / (this->radius * this->radius);
+	return Eigen::Vector3d(ax, ay, az) * scale;
+}
+
+void GravityField::build_tables()
+{
+	const int N = this->max_degree;
+	this->diag.assign(N + 2, 0.0);
+	this->a_nm.assign(idx(N + 2, 0), 0.0);
+	this->b_nm.assign(idx(N + 2, 0), 0.0);
+	for (int m = 1; m <= N + 1; m++)
+	{
+		//N(m, m) / N(m-1, m-1) * (2m - 1); m = 1 is special because only the m = 0 normalization drops the factor of 2
+		this->diag[m] = (m == 1) ? std::sqrt(3.0) : std::sqrt((2.0 * m + 1.0) / (2.0 * m));
+	}
+	for (int n = 1; n <= N + 1; n++)
+	{
+		for (int m = 0; m < n; m++)
+		{
+			const double nm_minus = n - m;
+			const double nm_plus = n + m;
+			this->a_nm[idx(n, m)] = std::sqrt((2.0 * n - 1.0) * (2.0 * n + 1.0) / (nm_minus * nm_plus));
+			if (n >= m + 2)
+			{
+				this->b_nm[idx(n, m)] = std::sqrt((2.0 * n + 1.0) * (nm_plus - 1.0) * (nm_minus - 1.0) / (nm_minus * nm_plus * (2.0 * n - 3.0)));
+			}
+		}
+	}
+
+	this->f_xy_up.assign(idx(N + 1, 0), 0.0);
+	this->f_xy_down.assign(idx(N + 1, 0), 0.0);
+	this->f_z.assign(idx(N + 1, 0), 0.0);
+	for (int n = 2; n <= N; n++)
+	{
+		const double ratio = (2.0 * n + 1.0) / (2.0 * n + 3.0);
+		for (int m = 0; m <= n; m++)
+		{
+			const std::size_t k = idx(n, m);
+			if (m == 0)
+			{
+				this->f_xy_up[k] = std::sqrt(ratio * (n + 1.0) * (n + 2.0) / 2.0);
+			}
+			else
+			{
+				const double k_down = (m == 1) ? 2.0 : 1.0; //same m = 0 normalization quirk
+				this->f_xy_up[k] = 0.5 * std::sqrt(ratio * (n + m + 1.0) * (n + m + 2.0));
+				this->f_xy_down[k] = 0.5 * std::sqrt(k_down * ratio * (n - m + 1.0) * (n - m + 2.0));
+			}
+			this->f_z[k] = std::sqrt(ratio * (n - m + 1.0) * (n + m + 1.0));
+		}
+	}
+}
+
+void GravityField::load(std::string file_name, bool header_required)
+{
+	std::ifstream file(file_name);
+	if (!file)
+	{
+		throw std::runtime_error("Could not open gravity field file " + file_name + ".");
+	}
+
+	this->C.assign(idx(this->max_degree + 1, 0), 0.0);
+	this->S.assign(idx(this->max_degree + 1, 0), 0.0);
+
+	bool in_header = header_required;
+	bool read_any = false;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream tokens(line);
+		std::string key;
+		if (!(tokens >> key))
+		{
+			continue;
+		}
+
+		if (in_header)
+		{
+			//ICGEM header; GM & radius are in SI units there
+			std::string value;
+			tokens >> value;
+			if (key == "end_of_head")
+			{
+				in_header = false;
+			}
+			else if (key.size() >= 16 && key.compare(key.size() - 16, 16, "gravity_constant") == 0)
+			{
+				this->mu = std::stod(value) * 1e-9;
+			}
+			else if (key == "radius")
+			{
+				this->radius = std::stod(value) * 1e-3;
+			}
+			else if (key == "norm" && value != "fully_normalized")
+			{
+				throw std::runtime_error("Gravity field file " + file_name + " isn't fully normalized.");
+			}
+			continue;
+		}
+
+		//coefficient rows; "gfc" rows in ICGEM files, bare rows in plain tables (time-variable gfct/trnd/... rows are skipped)
+		std::string row = line;
+		if (key == "gfc")
+		{
+			row = line.substr(line.find("gfc") + 3);
+		}
+		else if (!std::isdigit(static_cast<unsigned char>(key[0])))
+		{
+			continue;
+		}
+		std::replace(row.begin(), row.end(), 'D', 'E'); //fortran exponents (e.g. the EGM96 tables)
+		std::replace(row.begin(), row.end(), 'd', 'e');
+		std::istringstream values(row);
+		int n, m;
+		double Cnm, Snm;
+		if (!(values >> n >> m >> Cnm >> Snm))
+		{
+			throw std::runtime_error("Bad coefficient row in gravity field file " + file_name + ": " + line);
+		}
+		if (n <= this->max_degree && m <= n)
+		{
+			this->C[idx(n, m)] = Cnm;
+			this->S[idx(n, m)] = Snm;
+			read_any = true;
+		}
+	}
+
+	if (!read_any || (header_required && (this->mu <= 0.0 || this->radius <= 0.0)))
+	{
+		throw std::runtime_error("Gravity field file " + file_name + " is missing its coefficients, GM, or reference radius.");
+	}
+}
+#pragma endregion utilities
+
+SphericalHarmonicTerm::SphericalHarmonicTerm(const GravityField& field, const Planet& cb, int degree, int order) :
+	field(field), cb(cb), degree(degree), order(order)
+{
+}
+
+Eigen::Vector3d SphericalHarmonicTerm::accel_icrf(double et, const Eigen::Vector3d& r) const
+{
+	//note: icrf_R_bcf takes icrf vectors into the body-fixed frame (r_bcf = C * r_icrf), same as in AccessAnalyzer
+	const Eigen::Matrix3d C = this->cb.icrf_R_bcf(et);
+
+	return C.transpose() * this->field.accel(C * r, this->degree, this->order);
+}
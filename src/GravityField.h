@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+class Planet;
+
+class GravityField
+{
+public:
+	//fully normalized spherical harmonic gravity field (e.g. EGM96, EGM2008, GGM05C) truncated at max_degree on load
+	//accelerations come from the normalized Cunningham (V/W) recursion, which works directly in body-fixed cartesian
+	// coordinates (no singularity at the poles) and stays well scaled to degree/order in the hundreds
+	//every recursion & acceleration factor is tabulated once here; the only per-call memory is a per-thread scratch
+	// table that's reused across calls, so any number of threads can evaluate the same field at once
+	//note: the file constructor reads ICGEM .gfc files (header in SI units, "gfc n m C S ..." rows); plain tables with
+	//      "n m C S ..." rows & no header need the mu/radius overload. mu & radius are stored in km units
+	GravityField(std::string file_name, int max_degree);
+	GravityField(std::string file_name, int max_degree, double mu, double radius);
+	GravityField(double mu, double radius, int max_degree); //all coefficients zero; fill them in with set_coefficients
+
+	//don't want copies of the coefficient tables floating around
+	GravityField(const GravityField&) = delete;
+	GravityField& operator=(const GravityField&) = delete;
+	GravityField(GravityField&&) = delete;
+	GravityField& operator=(GravityField&&) = delete;
+
+	//getters
+	double get_mu() const; //[km^3/s^2]; the field's own reference GM (the coefficients are scaled to it)
+	double get_radius() const; //[km]; reference radius of the coefficients
+	int get_max_degree() const;
+	double get_C(int n, int m) const;
+	double get_S(int n, int m) const;
+
+	//setters
+	void set_coefficients(int n, int m, double C, double S);
+
+	//utilities
+	Eigen::Vector3d accel(const Eigen::Vector3d& r_bcf, int degree, int order) const;
+	//note: body-fixed acceleration from the degree 2..degree, order 0..order terms only (the central term is left to
+	//      KeplerTerm); degree & order are clamped to the loaded field
+
+private:
+	void build_tables(); //recursion & acceleration factors for the loaded degree
+	void load(std::string file_name, bool header_required);
+	static std::size_t idx(int n, int m) { return static_cast<std::size_t>(n) * (n + 1) / 2 + m; }
+	//note: everything is packed by degree (row n holds orders 0..n). the recursion runs along each row, where the
+	//      orders are independent of each other, so the inner loops are contiguous & free of dependency chains
+
+	double mu;
+	double radius;
+	int max_degree;
+
+	std::vector<double> C; //normalized coefficients, idx(n, m)
+	std::vector<double> S;
+
+	//recursion factors up to max_degree + 1 (the acceleration needs one degree more than the field), idx(n, m)
+	std::vector<double> diag; //sectoral step V(m-1, m-1) -> V(m, m), by m
+	std::vector<double> a_nm; //V(n, m) = a_nm * z * V(n-1, m) - b_nm * rho * V(n-2, m)
+	std::vector<double> b_nm;
+
+	//acceleration factors up to max_degree, idx(n, m)
+	std::vector<double> f_xy_up; //weight of V/W(n+1, m+1) in the x & y components (m = 0 uses it for V/W(n+1, 1))
+	std::vector<double> f_xy_down; //weight of V/W(n+1, m-1) (m > 0 only)
+	std::vector<double> f_z; //weight of V/W(n+1, m) in the z component
+};
+
+class SphericalHarmonicTerm
+{
+public:
+	//GravityField as a FusedGravity term (see astrokit/force_models.h); rotates into the planet's body-fixed frame at
+	// the stage epoch, evaluates the field there, and rotates the acceleration back
+	static constexpr bool needs_r5 = false;
+
+	SphericalHarmonicTerm(const GravityField& field, const Planet& cb, int degree, int order);
+
+	template <typename Geometry, typename Accel>
+	void add_accel(const Geometry& g, Accel& a) const
+	{
+		a += accel_icrf(g.t, g.r);
+	}
+
+	Eigen::Vector3d accel_icrf(double et, const Eigen::Vector3d& r) const;
+
+private:
+	const GravityField& field;
+	const Planet& cb;
+	int degree;
+	int order;
+};
@@ -5,16 +5,17 @@ GroundStation::GroundStation(std::string name) :
 	lon(0.0), lat(0.0), elevation_mask(0.0)
 {
 	set_name(name);
+	compute_surface_normal();
 }
 
-GroundStation::GroundStation(std::string name, double lon, double lat) : elevation_mask(0.0)
+GroundStation::GroundStation(std::string name, double lon, double lat) : lon(0.0), lat(0.0), elevation_mask(0.0)
 {
 	set_name(name);
 	set_lon(lon);
 	set_lat(lat);
 }
 
-GroundStation::GroundStation(std::string name, double lon, double lat, double elev_mask)
+GroundStation::GroundStation(std::string name, double lon, double lat, double elev_mask) : lon(0.0), lat(0.0)
 {
 	set_name(name);
 	set_lon(lon);
@@ -55,11 +56,13 @@ void GroundStation::set_name(std::string new_name)
 void GroundStation::set_lon(double new_lon)
 {
 	this->lon = new_lon;
+	compute_surface_normal(); //keep the normal in sync with the location
 }
 
 void GroundStation::set_lat(double new_lat)
 {
 	this->lat = new_lat;
+	compute_surface_normal();
 }
 
 void GroundStation::set_elevation_mask(double new_elev_mask)
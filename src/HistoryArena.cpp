@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "HistoryArena.h"
+
+HistoryArena::HistoryArena() : data(), rows(0), capacity(0), coe_rows(0), first_row(0), with_coes(true), segments()
+{
+}
+
+HistoryArena::HistoryArena(bool with_coes) : data(), rows(0), capacity(0), coe_rows(0), first_row(0), with_coes(with_coes), segments()
+{
+}
+
+#pragma region getters
+std::size_t HistoryArena::get_rows() const
+{
+	return this->rows;
+}
+
+std::size_t HistoryArena::get_capacity() const
+{
+	return this->capacity;
+}
+
+std::size_t HistoryArena::get_coe_rows() const
+{
+	return this->coe_rows;
+}
+
+std::size_t HistoryArena::get_first_row() const
+{
+	return this->first_row;
+}
+
+int HistoryArena::get_cols() const
+{
+	return this->with_coes ? 13 : 7;
+}
+
+bool HistoryArena::has_coes() const
+{
+	return this->with_coes;
+}
+
+double HistoryArena::et_at(std::size_t row) const
+{
+	return col_ptr(ET_COL)[row];
+}
+
+Eigen::Vector<double, 6> HistoryArena::cart_at(std::size_t row) const
+{
+	Eigen::Vector<double, 6> cart;
+	for (int c = 0; c < 6; c++)
+	{
+		cart[c] = col_ptr(CART_COL + c)[row];
+	}
+	return cart;
+}
+
+Eigen::Vector<double, 6> HistoryArena::coe_at(std::size_t row) const
+{
+	Eigen::Vector<double, 6> coes;
+	for (int c = 0; c < 6; c++)
+	{
+		coes[c] = col_ptr(COE_COL + c)[row];
+	}
+	return coes;
+}
+
+HistoryArena::ConstColumn HistoryArena::column(int col) const
+{
+	return ConstColumn(col_ptr(col), this->rows);
+}
+
+HistoryArena::ConstBlock HistoryArena::block(std::size_t row0, std::size_t n_rows, int col0, int n_cols) const
+{
+	if (row0 + n_rows > this->rows || col0 + n_cols > get_cols())
+	{
+		throw std::runtime_error("HistoryArena block out of range.");
+	}
+	return ConstBlock(col_ptr(col0) + row0, n_rows, n_cols, Eigen::OuterStride<>(std::max<std::size_t>(this->capacity, 1)));
+}
+
+HistoryArena::ConstBlock HistoryArena::all() const
+{
+	return block(0, this->rows, 0, get_cols());
+}
+
+HistoryArena::ConstColumn HistoryArena::et() const
+{
+	return column(ET_COL);
+}
+
+HistoryArena::ConstBlock HistoryArena::cartesian() const
+{
+	return block(0, this->rows, CART_COL, 6);
+}
+
+HistoryArena::ConstBlock HistoryArena::coes() const
+{
+	if (!this->with_coes)
+	{
+		throw std::runtime_error("HistoryArena has no orbital element columns.");
+	}
+	return block(0, this->coe_rows, COE_COL, 6);
+}
+
+std::size_t HistoryArena::find_row(double et) const
+{
+	if (this->rows == 0)
+	{
+		throw std::runtime_error("HistoryArena time lookup on an empty history.");
+	}
+	const double* ets = col_ptr(ET_COL);
+	const double direction = (ets[this->rows - 1] < ets[0]) ? -1.0 : 1.0; //backward propagation runs the other way
+
+	//binary search over the segment starts, then index into the segment arithmetically
+	//note: the step is only a guess at the index; it's corrected against the stored ets, so rounding in how the
+	//      epochs were accumulated can't put us on the wrong row
+	auto seg = std::upper_bound(this->segments.begin(), this->segments.end(), et,
+		[direction](double t, const TimeSegment& s) { return direction * (t - s.et0) < 0.0; });
+	if (seg == this->segments.begin())
+	{
+		return 0;
+	}
+	--seg;
+	std::size_t k = 0;
+	if (seg->step != 0.0)
+	{
+		double steps = std::floor((et - seg->et0) / seg->step);
+		k = static_cast<std::size_t>(std::clamp(steps, 0.0, static_cast<double>(seg->rows - 1)));
+	}
+	std::size_t row = seg->row0 + k - this->first_row;
+	while (row + 1 < this->rows && direction * (ets[row + 1] - et) <= 0.0)
+	{
+		row++;
+	}
+	while (row > 0 && direction * (ets[row] - et) > 0.0)
+	{
+		row--;
+	}
+	return row;
+}
+
+std::pair<std::size_t, std::size_t> HistoryArena::find_rows(double et0, double et1) const
+{
+	return { find_row(et0), find_row(et1) };
+}
+
+std::size_t HistoryArena::get_time_segment_count() const
+{
+	return this->segments.size();
+}
+#pragma endregion getters
+
+#pragma region setters
+void HistoryArena::set_coes(std::size_t row, const Eigen::Vector<double, 6>& coes)
+{
+	if (!this->with_coes || row > this->coe_rows || row >= this->rows)
+	{
+		throw std::runtime_error("HistoryArena element rows must be filled in order.");
+	}
+	for (int c = 0; c < 6; c++)
+	{
+		col_ptr(COE_COL + c)[row] = coes[c];
+	}
+	this->coe_rows = std::max(this->coe_rows, row + 1);
+}
+
+void HistoryArena::set_with_coes(bool with_coes)
+{
+	if (with_coes != this->with_coes)
+	{
+		//keep the et & cartesian columns, just re-lay the arena out with the new column count
+		std::size_t old_cols = get_cols();
+		std::vector<double> old_data;
+		old_data.swap(this->data);
+
+		this->with_coes = with_coes;
+		this->coe_rows = 0;
+		this->data.assign(get_cols() * this->capacity, 0.0);
+		for (int c = 0; c < std::min<int>(old_cols, get_cols()); c++)
+		{
+			std::copy_n(old_data.begin() + c * this->capacity, this->rows, this->data.begin() + c * this->capacity);
+		}
+	}
+}
+#pragma endregion setters
+
+#pragma region utilities
+void HistoryArena::reserve(std::size_t n_rows)
+{
+	if (n_rows > this->capacity)
+	{
+		grow(n_rows);
+	}
+}
+
+void HistoryArena::clear()
+{
+	this->rows = 0;
+	this->coe_rows = 0;
+	this->first_row = 0;
+	this->segments.clear();
+}
+
+void HistoryArena::append(double et, const Eigen::Vector<double, 6>& cart)
+{
+	if (this->rows == this->capacity)
+	{
+		grow(std::max<std::size_t>(64, 2 * this->capacity)); //amortized growth if nobody sized us up front
+	}
+	col_ptr(ET_COL)[this->rows] = et;
+	for (int c = 0; c < 6; c++)
+	{
+		col_ptr(CART_COL + c)[this->rows] = cart[c];
+	}
+	index_time(et);
+	this->rows++;
+}
+
+void HistoryArena::discard_front(std::size_t n_rows)
+{
+	n_rows = std::min(n_rows, this->rows);
+	if (n_rows == 0)
+	{
+		return;
+	}
+	//slide the surviving rows of every column down to the start of the column; capacity stays put
+	for (int c = 0; c < get_cols(); c++)
+	{
+		double* p = col_ptr(c);
+		std::copy(p + n_rows, p + this->rows, p);
+	}
+	this->rows -= n_rows;
+	this->coe_rows -= std::min(n_rows, this->coe_rows);
+	this->first_row += n_rows;
+
+	//drop the segments that went with those rows & trim the one that now starts the history
+	auto keep = std::find_if(this->segments.begin(), this->segments.end(),
+		[this](const TimeSegment& s) { return s.row0 + s.rows > this->first_row; });
+	this->segments.erase(this->segments.begin(), keep);
+	if (!this->segments.empty() && this->segments.front().row0 < this->first_row)
+	{
+		TimeSegment& front = this->segments.front();
+		front.rows -= this->first_row - front.row0;
+		front.row0 = this->first_row;
+		front.et0 = col_ptr(ET_COL)[0];
+	}
+}
+
+HistoryArena HistoryArena::snapshot() const
+{
+	HistoryArena copy(this->with_coes);
+	copy.grow(this->rows);
+	for (int c = 0; c < get_cols(); c++)
+	{
+		std::copy_n(col_ptr(c), this->rows, copy.col_ptr(c));
+	}
+	copy.rows = this->rows;
+	copy.coe_rows = this->coe_rows;
+	copy.first_row = this->first_row;
+	copy.segments = this->segments;
+	return copy;
+}
+
+void HistoryArena::index_time(double et)
+{
+	//called before rows is bumped, so the new row is overall row first_row + rows
+	//note: a row stays in the segment while it lands within a millionth of a step of et0 + k * step. checking against
+	//      the segment start (not the previous row) keeps accumulated rounding in the epochs from drifting the index
+	if (!this->segments.empty())
+	{
+		TimeSegment& last = this->segments.back();
+		if (last.rows == 1 && et != last.et0)
+		{
+			last.step = et - last.et0;
+			last.rows++;
+			return;
+		}
+		if (last.rows > 1 && std::abs(et - (last.et0 + last.rows * last.step)) <= 1e-6 * std::abs(last.step))
+		{
+			last.rows++;
+			return;
+		}
+	}
+	this->segments.push_back(TimeSegment{ this->first_row + this->rows, 1, et, 0.0 });
+}
+
+void HistoryArena::grow(std::size_t new_capacity)
+{
+	std::vector<double> new_data(get_cols() * new_capacity);
+	for (int c = 0; c < get_cols(); c++)
+	{
+		std::copy_n(this->data.begin() + c * this->capacity, this->rows, new_data.begin() + c * new_capacity);
+	}
+	this->data.swap(new_data);
+	this->capacity = new_capacity;
+}
+
+double* HistoryArena::col_ptr(int col)
+{
+	return this->data.data() + col * this->capacity;
+}
+
+const double* HistoryArena::col_ptr(int col) const
+{
+	return this->data.data() + col * this->capacity;
+}
+#pragma endregion utilities
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <Eigen/Dense>
+
+class HistoryArena
+{
+public:
+	//single columnar store for a spacecraft's state history; each column is one contiguous block of doubles so
+	// analysis & export can work on zero-copy Eigen::Map views instead of rebuilding matrices
+	//column layout (matches the csv export):
+	//et, rx, ry, rz, vx, vy, vz, sma, ecc, inc, raan, argp, ta
+	// 0,  1,  2,  3,  4,  5,  6,   7,   8,   9,   10,   11, 12
+	static constexpr int ET_COL = 0;
+	static constexpr int CART_COL = 1;
+	static constexpr int COE_COL = 7;
+
+	using ConstBlock = Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<>>;
+	using ConstColumn = Eigen::Map<const Eigen::VectorXd>;
+
+	HistoryArena();
+	HistoryArena(bool with_coes);
+
+	//getters
+	std::size_t get_rows() const;
+	std::size_t get_capacity() const;
+	std::size_t get_coe_rows() const; //leading rows whose element columns have been filled in
+	std::size_t get_first_row() const; //overall row number of row 0; non-zero once older rows have been discarded
+	int get_cols() const; //13 with elements, 7 without
+	bool has_coes() const;
+
+	double et_at(std::size_t row) const;
+	Eigen::Vector<double, 6> cart_at(std::size_t row) const;
+	Eigen::Vector<double, 6> coe_at(std::size_t row) const;
+
+	//zero-copy views; only valid until the next append/reserve (which may reallocate)
+	ConstColumn column(int col) const;
+	ConstBlock block(std::size_t row0, std::size_t n_rows, int col0, int n_cols) const;
+	ConstBlock all() const; //every row & column
+	ConstColumn et() const;
+	ConstBlock cartesian() const;
+	ConstBlock coes() const; //only the get_coe_rows() rows that are filled in
+
+	//time lookups; rows are indexed by segment as they're appended (see TimeSegment), so these don't scan the et column
+	std::size_t find_row(double et) const; //last row at or before et (along the propagation direction), clamped to the rows we have
+	std::pair<std::size_t, std::size_t> find_rows(double et0, double et1) const; //{find_row(et0), find_row(et1)}; rows covering [et0, et1]
+	std::size_t get_time_segment_count() const;
+
+	//setters
+	void set_coes(std::size_t row, const Eigen::Vector<double, 6>& coes); //rows must be filled in order
+	void set_with_coes(bool with_coes); //drops the element columns entirely when false (clears the arena)
+
+	//utilities
+	void reserve(std::size_t n_rows); //size the arena up front (e.g. duration / step from Constellation::propagate)
+	void clear();
+	void append(double et, const Eigen::Vector<double, 6>& cart);
+	void discard_front(std::size_t n_rows); //drops the oldest n_rows rows (e.g. once they've been streamed out)
+	HistoryArena snapshot() const; //compact copy of the filled rows (capacity == rows) for handing off to another thread
+
+private:
+	struct TimeSegment //run of rows on a uniform time step
+	{
+		std::size_t row0; //overall row number (see get_first_row) of the segment's first row
+		std::size_t rows;
+		double et0;
+		double step; //0 until the segment has a second row
+	};
+
+	void grow(std::size_t new_capacity);
+	void index_time(double et); //extends the last segment with the new row or starts another one
+	double* col_ptr(int col);
+	const double* col_ptr(int col) const;
+
+	std::vector<double> data; //column-major; column c starts at c * capacity
+	std::size_t rows;
+	std::size_t capacity;
+	std::size_t coe_rows;
+	std::size_t first_row;
+	bool with_coes;
+
+	std::vector<TimeSegment> segments; //in row order; fixed-step histories stay one segment (plus one per partial step)
+};
@@ -0,0 +1,379 @@
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <bit>
+#include <charconv>
+#include "HistoryFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr char MAGIC[8] = { 'C', 'S', 'I', 'M', 'H', 'I', 'S', 'T' };
+	constexpr std::size_t FIXED_HEADER_SIZE = 8 + 4 + 4 + 8 + 8 + 8 + 8;
+	constexpr std::size_t ALIGNMENT = 64;
+
+	//note: the format is little-endian on disk; everything we target is too, so the data columns go out as-is
+	static_assert(std::endian::native == std::endian::little, "HistoryFile assumes a little-endian host");
+
+	template <typename T>
+	void put(std::vector<char>& buf, T value)
+	{
+		const char* p = reinterpret_cast<const char*>(&value);
+		buf.insert(buf.end(), p, p + sizeof(T));
+	}
+
+	void put_string(std::vector<char>& buf, const std::string& s)
+	{
+		put(buf, static_cast<std::uint32_t>(s.size()));
+		buf.insert(buf.end(), s.begin(), s.end());
+	}
+
+	template <typename T>
+	T get(const char* base, std::size_t size, std::size_t& offset)
+	{
+		if (offset + sizeof(T) > size)
+		{
+			throw std::runtime_error("History file header is truncated.");
+		}
+		T value;
+		std::memcpy(&value, base + offset, sizeof(T));
+		offset += sizeof(T);
+		return value;
+	}
+
+	std::string get_string(const char* base, std::size_t size, std::size_t& offset)
+	{
+		std::uint32_t len = get<std::uint32_t>(base, size, offset);
+		if (offset + len > size)
+		{
+			throw std::runtime_error("History file header is truncated.");
+		}
+		std::string s(base + offset, len);
+		offset += len;
+		return s;
+	}
+}
+
+HistoryFile::HistoryFile(std::string filename) :
+	filename(filename), epoch(0.0), n_rows(0), row_capacity(0), data_offset(0),
+	mapped(nullptr), mapped_size(0), map_handle(nullptr), file_handle(nullptr)
+{
+	map_file();
+	try
+	{
+		parse_header();
+	}
+	catch (...)
+	{
+		unmap_file();
+		throw;
+	}
+}
+
+HistoryFile::~HistoryFile()
+{
+	unmap_file();
+}
+
+#pragma region getters
+std::string HistoryFile::get_filename() const
+{
+	return this->filename;
+}
+
+std::string HistoryFile::get_name() const
+{
+	return this->name;
+}
+
+std::string HistoryFile::get_frame() const
+{
+	return this->frame;
+}
+
+double HistoryFile::get_epoch() const
+{
+	return this->epoch;
+}
+
+std::size_t HistoryFile::get_rows() const
+{
+	return static_cast<std::size_t>(this->n_rows);
+}
+
+const std::vector<std::string>& HistoryFile::get_column_names() const
+{
+	return this->col_names;
+}
+
+std::span<const double> HistoryFile::column(std::size_t col) const
+{
+	if (col >= this->col_names.size())
+	{
+		throw std::runtime_error("Column index out of range for history file " + this->filename + ".");
+	}
+	const double* p = reinterpret_cast<const double*>(this->mapped + this->data_offset) + col * this->row_capacity;
+	return std::span<const double>(p, static_cast<std::size_t>(this->n_rows));
+}
+
+std::span<const double> HistoryFile::column(const std::string& col_name) const
+{
+	for (std::size_t i = 0; i < this->col_names.size(); i++)
+	{
+		if (this->col_names[i] == col_name)
+		{
+			return column(i);
+		}
+	}
+	throw std::runtime_error("No column named " + col_name + " in history file " + this->filename + ".");
+}
+#pragma endregion getters
+
+#pragma region utilities
+void HistoryFile::write(std::string filename, std::string sc_name, std::string frame, const HistoryArena& history)
+{
+	std::size_t n_rows = history.get_rows();
+	int n_cols = history.get_cols();
+	double epoch = (n_rows > 0) ? history.et_at(0) : 0.0;
+
+	std::vector<char> header = build_header(sc_name, frame, epoch, n_rows, n_rows, column_names(history.has_coes()));
+
+	std::ofstream f(filename, std::ios::binary | std::ios::trunc);
+	if (!f)
+	{
+		throw std::runtime_error("Could not open " + filename + " for writing.");
+	}
+	f.write(header.data(), header.size());
+
+	//each arena column is already one contiguous block, so it goes out in a single write
+	for (int c = 0; c < n_cols; c++)
+	{
+		f.write(reinterpret_cast<const char*>(history.column(c).data()), n_rows * sizeof(double));
+	}
+
+	if (!f)
+	{
+		throw std::runtime_error("Failed while writing history file " + filename + ".");
+	}
+}
+
+void HistoryFile::write_csv(std::string filename, const HistoryArena& history)
+{
+	std::ofstream f(filename, std::ios::binary | std::ios::trunc);
+	if (!f)
+	{
+		throw std::runtime_error("Could not open " + filename + " for writing.");
+	}
+
+	std::vector<std::string> names = column_names(history.has_coes());
+	std::string header;
+	for (std::size_t c = 0; c < names.size(); c++)
+	{
+		header += names[c];
+		header += (c + 1 < names.size()) ? ',' : '\n';
+	}
+	f.write(header.data(), header.size());
+
+	int n_cols = history.get_cols();
+	std::vector<const double*> cols(n_cols);
+	for (int c = 0; c < n_cols; c++)
+	{
+		cols[c] = history.column(c).data();
+	}
+
+	//a double is at most 24 characters in shortest form; flush whenever a full row might not fit
+	constexpr std::size_t BUFFER_SIZE = 1 << 20;
+	const std::size_t max_row_chars = n_cols * 25;
+	std::vector<char> buf(BUFFER_SIZE);
+	char* out = buf.data();
+	char* const end = buf.data() + buf.size();
+
+	for (std::size_t r = 0; r < history.get_rows(); r++)
+	{
+		if (static_cast<std::size_t>(end - out) < max_row_chars)
+		{
+			f.write(buf.data(), out - buf.data());
+			out = buf.data();
+		}
+		for (int c = 0; c < n_cols; c++)
+		{
+			out = std::to_chars(out, end, cols[c][r]).ptr;
+			*out++ = (c + 1 < n_cols) ? ',' : '\n';
+		}
+	}
+	f.write(buf.data(), out - buf.data());
+
+	if (!f)
+	{
+		throw std::runtime_error("Failed while writing history file " + filename + ".");
+	}
+}
+
+std::string HistoryFile::unique_file_name(const std::string& stem, const std::string& extension, std::unordered_set<std::string>& used)
+{
+	std::string name = stem + extension;
+	for (int counter = 1; used.count(name) > 0; counter++)
+	{
+		name = stem + std::to_string(counter) + extension;
+	}
+	used.insert(name);
+	return name;
+}
+
+std::vector<std::string> HistoryFile::column_names(bool with_coes)
+{
+	std::vector<std::string> names{ "et", "rx", "ry", "rz", "vx", "vy", "vz" };
+	if (with_coes)
+	{
+		names.insert(names.end(), { "sma", "ecc", "inc", "raan", "argp", "ta" });
+	}
+	return names;
+}
+
+std::vector<char> HistoryFile::build_header(std::string sc_name, std::string frame, double epoch, std::uint64_t n_rows,
+											std::uint64_t row_capacity, const std::vector<std::string>& col_names)
+{
+	//variable-length part first so we know where the data starts
+	std::vector<char> strings;
+	put_string(strings, sc_name);
+	put_string(strings, frame);
+	for (const auto& col_name : col_names)
+	{
+		put_string(strings, col_name);
+	}
+
+	std::uint64_t data_offset = FIXED_HEADER_SIZE + strings.size();
+	data_offset = ((data_offset + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+
+	std::vector<char> header;
+	header.reserve(data_offset);
+	header.insert(header.end(), MAGIC, MAGIC + sizeof(MAGIC));
+	put(header, VERSION);
+	put(header, static_cast<std::uint32_t>(col_names.size()));
+	put(header, n_rows);
+	put(header, row_capacity);
+	put(header, data_offset);
+	put(header, epoch);
+	header.insert(header.end(), strings.begin(), strings.end());
+	header.resize(data_offset, 0); //zero padding so the columns start on a cache line
+
+	return header;
+}
+
+void HistoryFile::parse_header()
+{
+	std::size_t offset = 0;
+	if (this->mapped_size < FIXED_HEADER_SIZE || std::memcmp(this->mapped, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		throw std::runtime_error(this->filename + " is not a history file.");
+	}
+	offset += sizeof(MAGIC);
+
+	std::uint32_t version = get<std::uint32_t>(this->mapped, this->mapped_size, offset);
+	if (version != VERSION)
+	{
+		throw std::runtime_error("Unsupported history file version " + std::to_string(version) + " in " + this->filename + ".");
+	}
+	std::uint32_t n_cols = get<std::uint32_t>(this->mapped, this->mapped_size, offset);
+	this->n_rows = get<std::uint64_t>(this->mapped, this->mapped_size, offset);
+	this->row_capacity = get<std::uint64_t>(this->mapped, this->mapped_size, offset);
+	this->data_offset = get<std::uint64_t>(this->mapped, this->mapped_size, offset);
+	this->epoch = get<double>(this->mapped, this->mapped_size, offset);
+
+	this->name = get_string(this->mapped, this->mapped_size, offset);
+	this->frame = get_string(this->mapped, this->mapped_size, offset);
+	this->col_names.clear();
+	for (std::uint32_t i = 0; i < n_cols; i++)
+	{
+		this->col_names.push_back(get_string(this->mapped, this->mapped_size, offset));
+	}
+
+	//sanity checks before handing out spans into the mapping
+	if (this->n_rows > this->row_capacity || this->data_offset < offset || this->data_offset % sizeof(double) != 0 ||
+		this->data_offset + n_cols * this->row_capacity * sizeof(double) > this->mapped_size)
+	{
+		throw std::runtime_error("History file " + this->filename + " is corrupt or truncated.");
+	}
+}
+
+void HistoryFile::map_file()
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(this->filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Could not open history file " + this->filename + ".");
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		throw std::runtime_error("History file " + this->filename + " is empty or unreadable.");
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		throw std::runtime_error("Could not map history file " + this->filename + ".");
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw std::runtime_error("Could not map history file " + this->filename + ".");
+	}
+	this->file_handle = file;
+	this->map_handle = mapping;
+	this->mapped = static_cast<const char*>(view);
+	this->mapped_size = static_cast<std::size_t>(size.QuadPart);
+#else
+	int fd = open(this->filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Could not open history file " + this->filename + ".");
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		throw std::runtime_error("History file " + this->filename + " is empty or unreadable.");
+	}
+	void* view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); //the mapping keeps its own reference to the file
+	if (view == MAP_FAILED)
+	{
+		throw std::runtime_error("Could not map history file " + this->filename + ".");
+	}
+	this->mapped = static_cast<const char*>(view);
+	this->mapped_size = static_cast<std::size_t>(st.st_size);
+#endif
+}
+
+void HistoryFile::unmap_file()
+{
+	if (this->mapped == nullptr)
+	{
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(this->mapped);
+	CloseHandle(static_cast<HANDLE>(this->map_handle));
+	CloseHandle(static_cast<HANDLE>(this->file_handle));
+#else
+	munmap(const_cast<char*>(this->mapped), this->mapped_size);
+#endif
+	this->mapped = nullptr;
+	this->mapped_size = 0;
+}
+#pragma endregion utilities
@@ -0,0 +1,77 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <unordered_set>
+#include "HistoryArena.h"
+
+class HistoryFile
+{
+public:
+	//binary columnar history format + a reader that memory-maps the file and hands out zero-copy column spans
+	//layout (all little-endian):
+	//  fixed header: magic "CSIMHIST", u32 version, u32 n_cols, u64 n_rows, u64 row_capacity, u64 data_offset, f64 epoch
+	//  strings (u32 length + bytes each): spacecraft name, frame name, then one per column name
+	//  zero padding up to data_offset (a multiple of 64 bytes)
+	//  column c occupies row_capacity doubles starting at data_offset + c * row_capacity * 8; only the first n_rows are valid
+	//note: row_capacity lets streaming writers preallocate the columns and fill them in chunks (n_rows <= row_capacity)
+	static constexpr std::uint32_t VERSION = 1;
+	//byte offsets of the fixed header fields a streaming writer patches in place
+	static constexpr std::size_t N_ROWS_OFFSET = 16;
+	static constexpr std::size_t ROW_CAPACITY_OFFSET = 24;
+	static constexpr std::size_t EPOCH_OFFSET = 40;
+
+	HistoryFile(std::string filename); //opens & maps the file read-only
+	~HistoryFile();
+
+	//owns the mapping; don't want it to be copyable
+	HistoryFile(const HistoryFile&) = delete;
+	HistoryFile& operator=(const HistoryFile&) = delete;
+	HistoryFile(HistoryFile&&) = delete;
+	HistoryFile& operator=(HistoryFile&&) = delete;
+
+	//getters
+	std::string get_filename() const;
+	std::string get_name() const; //spacecraft name
+	std::string get_frame() const;
+	double get_epoch() const; //et of the first row
+	std::size_t get_rows() const;
+	const std::vector<std::string>& get_column_names() const;
+
+	std::span<const double> column(std::size_t col) const;
+	std::span<const double> column(const std::string& col_name) const;
+
+	//utilities
+	static void write(std::string filename, std::string sc_name, std::string frame, const HistoryArena& history);
+	//note: writes every row & column of the arena (13 columns with elements, 7 without)
+	static void write_csv(std::string filename, const HistoryArena& history);
+	//note: same columns as a text table; doubles are formatted with std::to_chars (shortest round-trip form)
+	//      into a large buffer that goes out in big writes
+
+	static std::string unique_file_name(const std::string& stem, const std::string& extension, std::unordered_set<std::string>& used);
+	//note: stem + extension, or stem + 1, 2, ... + extension until the name isn't in used (the name is added to used).
+	//      checking the final names rather than counting repeats of the stem means "s", "s", "s1" can't collide
+	static std::vector<std::string> column_names(bool with_coes);
+	static std::vector<char> build_header(std::string sc_name, std::string frame, double epoch, std::uint64_t n_rows,
+										  std::uint64_t row_capacity, const std::vector<std::string>& col_names);
+
+private:
+	void map_file();
+	void unmap_file();
+	void parse_header();
+
+	std::string filename;
+	std::string name;
+	std::string frame;
+	double epoch;
+	std::uint64_t n_rows;
+	std::uint64_t row_capacity;
+	std::uint64_t data_offset;
+	std::vector<std::string> col_names;
+
+	const char* mapped; //start of the mapping
+	std::size_t mapped_size;
+	void* map_handle; //file mapping handle on Windows; unused elsewhere
+	void* file_handle; //file handle on Windows; unused elsewhere
+};
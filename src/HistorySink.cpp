@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <stdexcept>
+#include "HistorySink.h"
+#include "HistoryFile.h"
+
+HistoryFileSink::HistoryFileSink(std::string file_name_root) : file_name_root(file_name_root)
+{
+}
+
+HistoryFileSink::~HistoryFileSink()
+{
+	try
+	{
+		finish();
+	}
+	catch (...)
+	{
+		//nothing sensible to do with a write error while being destroyed
+	}
+}
+
+#pragma region getters
+std::vector<std::string> HistoryFileSink::get_filenames() const
+{
+	std::vector<std::string> filenames;
+	for (const auto& file : this->files)
+	{
+		if (file)
+		{
+			filenames.push_back(file->filename);
+		}
+	}
+	return filenames;
+}
+#pragma endregion getters
+
+#pragma region utilities
+void HistoryFileSink::reserve(std::size_t sc_index, const std::string& sc_name, bool with_coes, std::size_t total_rows)
+{
+	OpenFile& file = open_file(sc_index, sc_name, with_coes ? 13 : 7, total_rows);
+	ensure_capacity(file, total_rows);
+}
+
+void HistoryFileSink::write(std::size_t sc_index, const std::string& sc_name, std::size_t first_row, HistoryArena::ConstBlock rows)
+{
+	OpenFile& file = open_file(sc_index, sc_name, rows.cols(), first_row + rows.rows());
+	if (static_cast<std::size_t>(rows.cols()) != file.n_cols)
+	{
+		throw std::runtime_error("History column count changed while streaming " + file.filename + ".");
+	}
+	if (rows.rows() == 0)
+	{
+		return;
+	}
+	ensure_capacity(file, first_row + rows.rows());
+
+	//each column of the chunk is contiguous in the arena and lands contiguously in the file
+	for (std::size_t c = 0; c < file.n_cols; c++)
+	{
+		file.f.seekp(file.data_offset + (c * file.row_capacity + first_row) * sizeof(double));
+		file.f.write(reinterpret_cast<const char*>(rows.col(c).data()), rows.rows() * sizeof(double));
+	}
+	if (!file.f)
+	{
+		throw std::runtime_error("Failed while streaming history to " + file.filename + ".");
+	}
+
+	if (first_row == 0)
+	{
+		file.epoch = rows(0, HistoryArena::ET_COL);
+	}
+	file.n_rows = std::max(file.n_rows, first_row + rows.rows());
+}
+
+void HistoryFileSink::finish()
+{
+	//patch the header so the files are readable as they stand; they stay open for the next propagate
+	for (auto& file : this->files)
+	{
+		if (!file)
+		{
+			continue;
+		}
+		std::uint64_t n_rows = file->n_rows;
+		file->f.seekp(HistoryFile::N_ROWS_OFFSET);
+		file->f.write(reinterpret_cast<const char*>(&n_rows), sizeof(n_rows));
+		file->f.seekp(HistoryFile::EPOCH_OFFSET);
+		file->f.write(reinterpret_cast<const char*>(&file->epoch), sizeof(file->epoch));
+		file->f.flush();
+		if (!file->f)
+		{
+			throw std::runtime_error("Failed while finishing history file " + file->filename + ".");
+		}
+	}
+}
+
+HistoryFileSink::OpenFile& HistoryFileSink::open_file(std::size_t sc_index, const std::string& sc_name, std::size_t n_cols, std::size_t total_rows)
+{
+	if (sc_index >= this->files.size())
+	{
+		this->files.resize(sc_index + 1);
+	}
+	if (this->files[sc_index])
+	{
+		return *this->files[sc_index];
+	}
+
+	std::string filename = HistoryFile::unique_file_name(this->file_name_root + sc_name, ".bin", this->used_filenames);
+
+	auto file = std::make_unique<OpenFile>();
+	file->filename = filename;
+	file->n_cols = n_cols;
+	file->row_capacity = std::max<std::size_t>(total_rows, 1);
+	file->n_rows = 0;
+	file->epoch = 0.0;
+
+	std::vector<char> header = HistoryFile::build_header(sc_name, "J2000", 0.0, 0, file->row_capacity,
+														 HistoryFile::column_names(n_cols == 13));
+	file->data_offset = header.size();
+
+	file->f.open(filename, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file->f)
+	{
+		throw std::runtime_error("Could not open " + filename + " for writing.");
+	}
+	file->f.write(header.data(), header.size());
+
+	//extend the file over the preallocated columns so it's always the full size the header promises
+	char zero = 0;
+	file->f.seekp(file->data_offset + file->n_cols * file->row_capacity * sizeof(double) - 1);
+	file->f.write(&zero, 1);
+
+	this->files[sc_index] = std::move(file);
+	return *this->files[sc_index];
+}
+
+void HistoryFileSink::ensure_capacity(OpenFile& file, std::size_t total_rows)
+{
+	if (total_rows <= file.row_capacity)
+	{
+		return;
+	}
+	//only happens if the run outgrows what reserve() promised; move the columns apart, last column first so
+	// nothing gets overwritten before it's been moved
+	std::size_t new_capacity = std::max(total_rows, 2 * file.row_capacity);
+	std::vector<double> buf(file.n_rows);
+	for (std::size_t c = file.n_cols; c-- > 1;)
+	{
+		file.f.seekg(file.data_offset + c * file.row_capacity * sizeof(double));
+		file.f.read(reinterpret_cast<char*>(buf.data()), buf.size() * sizeof(double));
+		file.f.seekp(file.data_offset + c * new_capacity * sizeof(double));
+		file.f.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(double));
+	}
+	file.row_capacity = new_capacity;
+
+	std::uint64_t capacity = new_capacity;
+	file.f.seekp(HistoryFile::ROW_CAPACITY_OFFSET);
+	file.f.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+	char zero = 0;
+	file.f.seekp(file.data_offset + file.n_cols * file.row_capacity * sizeof(double) - 1);
+	file.f.write(&zero, 1);
+
+	if (!file.f)
+	{
+		throw std::runtime_error("Failed while growing history file " + file.filename + ".");
+	}
+}
+#pragma endregion utilities
+
+HistoryCallbackSink::HistoryCallbackSink(Callback callback) : callback(callback)
+{
+}
+
+void HistoryCallbackSink::write(std::size_t sc_index, const std::string& sc_name, std::size_t first_row, HistoryArena::ConstBlock rows)
+{
+	this->callback(sc_index, sc_name, first_row, rows);
+}
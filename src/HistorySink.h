@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <unordered_set>
+#include "HistoryArena.h"
+
+class HistorySink
+{
+public:
+	//receives spacecraft history rows as Constellation::propagate streams them out (see PropagationOptions::history_sink)
+	//note: rows arrive in order for each spacecraft; first_row is the row's overall index in that spacecraft's history.
+	//      every call comes from the thread that called propagate, never from the workers
+	virtual ~HistorySink() = default;
+
+	virtual void reserve(std::size_t /*sc_index*/, const std::string& /*sc_name*/, bool /*with_coes*/, std::size_t /*total_rows*/) {}
+	//note: called at the start of each propagate with the row count the spacecraft will have reached by the end
+	virtual void write(std::size_t sc_index, const std::string& sc_name, std::size_t first_row, HistoryArena::ConstBlock rows) = 0;
+	//note: rows has the arena's column layout (13 columns with elements, 7 without) and is only valid during the call
+	virtual void finish() {} //called at the end of each propagate once everything has been written
+};
+
+class HistoryFileSink : public HistorySink
+{
+public:
+	//streams every spacecraft into its own binary history file (file_name_root + name + ".bin"; see HistoryFile.h)
+	//note: each file's columns are preallocated from reserve() and chunks are written straight to their column
+	//      offsets; the row count in the header is patched on finish(), so the file reads back like one from HistoryFile::write
+	HistoryFileSink(std::string file_name_root);
+	~HistoryFileSink() override;
+
+	//holds open files; don't want it to be copyable
+	HistoryFileSink(const HistoryFileSink&) = delete;
+	HistoryFileSink& operator=(const HistoryFileSink&) = delete;
+
+	//getters
+	std::vector<std::string> get_filenames() const;
+
+	//utilities
+	void reserve(std::size_t sc_index, const std::string& sc_name, bool with_coes, std::size_t total_rows) override;
+	void write(std::size_t sc_index, const std::string& sc_name, std::size_t first_row, HistoryArena::ConstBlock rows) override;
+	void finish() override;
+
+private:
+	struct OpenFile
+	{
+		std::string filename;
+		std::fstream f;
+		std::size_t n_cols;
+		std::size_t row_capacity;
+		std::size_t n_rows;
+		std::size_t data_offset;
+		double epoch;
+	};
+
+	OpenFile& open_file(std::size_t sc_index, const std::string& sc_name, std::size_t n_cols, std::size_t total_rows);
+	void ensure_capacity(OpenFile& file, std::size_t total_rows); //moves the columns apart if the file has to grow
+
+	std::string file_name_root;
+	std::vector<std::unique_ptr<OpenFile>> files; //indexed by spacecraft index
+	std::unordered_set<std::string> used_filenames; //spacecraft names can repeat; later ones get a counter appended (see HistoryFile::unique_file_name)
+};
+
+class HistoryCallbackSink : public HistorySink
+{
+public:
+	//hands each chunk to a user callback (e.g. for online analysis or a custom writer)
+	using Callback = std::function<void(std::size_t sc_index, const std::string& sc_name, std::size_t first_row, HistoryArena::ConstBlock rows)>;
+
+	HistoryCallbackSink(Callback callback);
+
+	void write(std::size_t sc_index, const std::string& sc_name, std::size_t first_row, HistoryArena::ConstBlock rows) override;
+
+private:
+	Callback callback;
+};
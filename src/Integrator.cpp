@@ -1,24 +1,251 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 #include "Integrator.h"
-#include <astrokit/integrators.h>
 
 
-Integrator::Integrator(Planet& cb, ForceModel& fm) : cb(cb), fm(fm)
+Integrator::Integrator(Planet& cb, ForceModel& fm) : cb(cb), fm(fm), method(IntegrationMethod::rk4), rel_tol(1e-10), abs_tol(1e-10)
 {
 }
 
+Integrator::Integrator(Planet& cb, ForceModel& fm, IntegrationMethod method, double rel_tol, double abs_tol) : cb(cb), fm(fm)
+{
+	set_method(method);
+	set_tolerances(rel_tol, abs_tol);
+}
+
+#pragma region getters
 const Planet& Integrator::get_cb() const
 {
 	return this->cb;
 }
 
+const ForceModel& Integrator::get_fm() const
+{
+	return this->fm;
+}
+
+IntegrationMethod Integrator::get_method() const
+{
+	return this->method;
+}
+
+double Integrator::get_rel_tol() const
+{
+	return this->rel_tol;
+}
+
+double Integrator::get_abs_tol() const
+{
+	return this->abs_tol;
+}
+
+bool Integrator::is_adaptive() const
+{
+	return this->method != IntegrationMethod::rk4;
+}
+#pragma endregion getters
+
+#pragma region setters
+void Integrator::set_method(IntegrationMethod new_method)
+{
+	this->method = new_method;
+}
+
+void Integrator::set_tolerances(double new_rel_tol, double new_abs_tol)
+{
+	if (new_rel_tol <= 0.0 && new_abs_tol <= 0.0)
+	{
+		throw std::runtime_error("Integrator tolerances must not both be zero.");
+	}
+	this->rel_tol = new_rel_tol;
+	this->abs_tol = new_abs_tol;
+}
+#pragma endregion setters
+
+#pragma region utilities
 Eigen::Vector<double, 6> Integrator::step(double t, double dt, const Eigen::Vector<double, 6>& state)
-//fixed-step RK4
 {
-	//need to use a lambda to make ForceModel's EOMs method work with astrokit (needs to be callable)
-	auto f = [this](double tt, const Eigen::Vector<double, 6>& yy)
+	if (is_adaptive())
+	{
+		Eigen::Vector<double, 6> err;
+		Eigen::Vector<double, 6> f_new;
+		astrokit::DenseStep<Eigen::Vector<double, 6>> dense;
+		return embedded_step(t, dt, state, eoms(t, state), err, f_new, dense);
+	}
+
+	//fixed-step RK4
+	//the force model hands over its fused gravity kernel (already callable as f(t, y)) once for the whole step
+	return fm.with_kernel([&](const auto& f)
+	{
+		return astrokit::rk4_step(t, dt, state, f);
+	});
+}
+
+Eigen::Vector<double, 6> Integrator::adaptive_step(double t, double& dt, const Eigen::Vector<double, 6>& state, double& dt_next)
+{
+	Eigen::Vector<double, 6> deriv = eoms(t, state);
+	astrokit::DenseStep<Eigen::Vector<double, 6>> dense;
+	return controlled_step(t, dt, state, deriv, dense, dt_next);
+}
+
+Eigen::Vector<double, 6> Integrator::dense_step(double t, double& dt, const Eigen::Vector<double, 6>& state, Eigen::Vector<double, 6>& deriv,
+												astrokit::DenseStep<Eigen::Vector<double, 6>>& dense, double& dt_next)
+{
+	if (this->method != IntegrationMethod::rkf78)
 	{
-		return fm.eoms(tt, yy);
-	};
+		return controlled_step(t, dt, state, deriv, dense, dt_next);
+	}
 
-	return astrokit::rk4_step(t, dt, state, f);
+	//RKF78's error control only covers the end of the step; left alone it takes steps far longer than its continuous
+	// extension can interpolate to the tolerances. the extension's error is checked through its defect at mid-step
+	// (one extra evaluation): the quintic's error goes as theta^3 * (1 - theta)^3, so a difference d between f at the
+	// interpolated state & the interpolant's own acceleration there means a position error of about dt^2 * |d| / 24 at
+	// mid-step and a velocity error of up to about 0.143 * dt * |d|. steps that fail are retried shorter, like rejected steps
+	const double safety = 0.9;
+	const double fac_min = 0.2;
+	const double fac_max = 5.0;
+	while (true)
+	{
+		Eigen::Vector<double, 6> deriv_new = deriv;
+		Eigen::Vector<double, 6> new_state = controlled_step(t, dt, state, deriv_new, dense, dt_next);
+
+		const double t_mid = t + 0.5 * dt;
+		const Eigen::Vector<double, 6> y_mid = dense.evaluate(t_mid);
+		const double defect = (eoms(t_mid, y_mid).segment<3>(3) - dense.derivative(t_mid).segment<3>(3)).norm();
+		const double pos_err = dt * dt * defect / 24.0 / (this->abs_tol + this->rel_tol * y_mid.segment<3>(0).norm());
+		const double vel_err = 0.143 * std::abs(dt) * defect / (this->abs_tol + this->rel_tol * y_mid.segment<3>(3).norm());
+		const double err_norm = std::max(pos_err, vel_err);
+
+		//the position error goes as dt^6 (the velocity's as dt^5; the position exponent is the cautious one for shrinking)
+		double fac = (err_norm > 0.0) ? safety * std::pow(err_norm, -1.0 / 6.0) : fac_max;
+		if (err_norm <= 1.0)
+		{
+			dt_next = std::copysign(std::min(std::abs(dt_next), std::abs(dt) * std::clamp(fac, fac_min, fac_max)), dt);
+			deriv = deriv_new;
+			return new_state;
+		}
+		dt *= std::max(fac_min, fac);
+	}
+}
+
+Eigen::Vector<double, 6> Integrator::controlled_step(double t, double& dt, const Eigen::Vector<double, 6>& state, Eigen::Vector<double, 6>& deriv,
+													 astrokit::DenseStep<Eigen::Vector<double, 6>>& dense, double& dt_next)
+{
+	if (!is_adaptive())
+	{
+		Eigen::Vector<double, 6> f_new;
+		Eigen::Vector<double, 6> new_state = fm.with_kernel([&](const auto& f)
+		{
+			return astrokit::rk4_dense_step(t, dt, state, deriv, f, f_new, dense);
+		});
+		deriv = f_new;
+		dt_next = dt;
+		return new_state;
+	}
+
+	//standard step size controller (Hairer, Norsett & Wanner): scale the step by (1/err)^(1/(q+1)) with a safety
+	// factor, limiting how fast it can grow or shrink
+	const double safety = 0.9;
+	const double fac_min = 0.2;
+	const double fac_max = 5.0;
+	const double exponent = 1.0 / (error_order() + 1.0);
+
+	bool rejected = false;
+	while (true)
+	{
+		Eigen::Vector<double, 6> err;
+		Eigen::Vector<double, 6> f_new;
+		Eigen::Vector<double, 6> new_state = embedded_step(t, dt, state, deriv, err, f_new, dense);
+		double err_norm = error_norm(state, new_state, err);
+
+		if (err_norm <= 1.0)
+		{
+			double fac = (err_norm > 0.0) ? safety * std::pow(err_norm, -exponent) : fac_max;
+			fac = std::clamp(fac, fac_min, rejected ? 1.0 : fac_max); //don't grow right after a rejection
+			dt_next = dt * fac;
+			deriv = f_new;
+			return new_state;
+		}
+
+		//rejected; shrink and retry (k1 = deriv is still valid since t & state haven't changed)
+		rejected = true;
+		double fac = std::max(fac_min, safety * std::pow(err_norm, -exponent));
+		dt *= fac;
+		if (std::abs(dt) < 16.0 * std::numeric_limits<double>::epsilon() * std::max(1.0, std::abs(t)))
+		{
+			throw std::runtime_error("Integrator step size underflow at t = " + std::to_string(t) + ".");
+		}
+	}
+}
+
+Eigen::Vector<double, 6> Integrator::propagate(double t0, double tf, const Eigen::Vector<double, 6>& state, double& dt_guess)
+{
+	if (!is_adaptive())
+	{
+		throw std::runtime_error("Integrator::propagate requires an adaptive integration method.");
+	}
+
+	const double dir = (tf >= t0) ? 1.0 : -1.0;
+	double t = t0;
+	Eigen::Vector<double, 6> y = state;
+	Eigen::Vector<double, 6> deriv = eoms(t0, state);
+	astrokit::DenseStep<Eigen::Vector<double, 6>> dense;
+	double dt = (dt_guess > 0.0) ? dir * dt_guess : tf - t0;
+
+	while (dir * (tf - t) > 0.0)
+	{
+		//clamp the last step so we land exactly on tf
+		bool last = dir * (t + dt - tf) >= 0.0;
+		double dt_try = last ? tf - t : dt;
+		double dt_next;
+
+		y = controlled_step(t, dt_try, y, deriv, dense, dt_next);
+		bool landed = last && dt_try == tf - t; //accepted without being shrunk
+		t = landed ? tf : t + dt_try;
+
+		//a clamped step is artificially short; don't let it drag down the step carried into the next call
+		dt = landed ? dir * std::max(std::abs(dt), std::abs(dt_next)) : dt_next;
+	}
+	dt_guess = std::abs(dt);
+	return y;
+}
+
+Eigen::Vector<double, 6> Integrator::eoms(double t, const Eigen::Vector<double, 6>& state)
+{
+	return fm.eoms(t, state);
+}
+
+Eigen::Vector<double, 6> Integrator::embedded_step(double t, double dt, const Eigen::Vector<double, 6>& state, const Eigen::Vector<double, 6>& k1,
+												   Eigen::Vector<double, 6>& err, Eigen::Vector<double, 6>& f_new,
+												   astrokit::DenseStep<Eigen::Vector<double, 6>>& dense)
+{
+	return fm.with_kernel([&](const auto& f)
+	{
+		if (this->method == IntegrationMethod::rkf78)
+		{
+			//RKF78 has no built-in interpolant; the end-point derivative (which doubles as the next step's k1) gives the
+			// quintic orbit extension, so it costs nothing extra over the 13 stages. a plain cubic Hermite isn't enough
+			// here: at the step sizes RKF78 takes it's off by up to km in LEO between the end points
+			Eigen::Vector<double, 6> new_state = astrokit::rkf78_step(t, dt, state, k1, f, err);
+			f_new = f(t + dt, new_state);
+			astrokit::orbit_hermite_dense(t, dt, state, k1, new_state, f_new, dense);
+			return new_state;
+		}
+		return astrokit::dopri54_step(t, dt, state, k1, f, err, f_new, dense);
+	});
+}
+
+double Integrator::error_norm(const Eigen::Vector<double, 6>& y0, const Eigen::Vector<double, 6>& y1, const Eigen::Vector<double, 6>& err) const
+{
+	//rms of the error scaled component-wise by atol + rtol * |y|; <= 1 means the step meets the tolerances
+	Eigen::Vector<double, 6> scale = (this->abs_tol + this->rel_tol * y0.cwiseAbs().cwiseMax(y1.cwiseAbs()).array()).matrix();
+	return std::sqrt((err.array() / scale.array()).square().mean());
+}
+
+int Integrator::error_order() const
+{
+	return (this->method == IntegrationMethod::rkf78) ? 7 : 4;
 }
+#pragma endregion utilities
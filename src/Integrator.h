@@ -2,12 +2,20 @@
 
 #include "Planet.h"
 #include "ForceModel.h"
+#include <astrokit/integrators.h>
 
+enum class IntegrationMethod
+{
+	rk4,     //classic fixed-step RK4
+	dopri54, //Dormand-Prince 5(4); adaptive, error-controlled
+	rkf78    //Runge-Kutta-Fehlberg 7(8); adaptive, error-controlled (better for long, tight-tolerance arcs)
+};
 
 class Integrator
 {
 public:
 	Integrator(Planet& cb, ForceModel& fm);
+	Integrator(Planet& cb, ForceModel& fm, IntegrationMethod method, double rel_tol, double abs_tol);
 
 	//going for a singleton-ish pattern for the Integrator class; don't want it to be copyable
 	Integrator(const Integrator&) = delete;
@@ -15,12 +23,52 @@ public:
 	Integrator(Integrator&&) = delete;
 	Integrator& operator=(Integrator&&) = delete;
 
+	//getters
 	const Planet& get_cb() const;
+	const ForceModel& get_fm() const;
+	IntegrationMethod get_method() const;
+	double get_rel_tol() const;
+	double get_abs_tol() const;
+	bool is_adaptive() const; //true for the embedded (error-controlled) methods
+
+	//setters
+	void set_method(IntegrationMethod new_method);
+	void set_tolerances(double new_rel_tol, double new_abs_tol);
 
+	//utilities
 	Eigen::Vector<double, 6> step(double t, double dt, const Eigen::Vector<double, 6>& state);
+	//note: a single step of the selected method with no error control
+
+	Eigen::Vector<double, 6> adaptive_step(double t, double& dt, const Eigen::Vector<double, 6>& state, double& dt_next);
+	//note: tries dt and shrinks it until the local error estimate meets the tolerances (rejected steps are retried);
+	//      on return dt holds the step actually taken and dt_next the predicted size of the next step
+
+	Eigen::Vector<double, 6> dense_step(double t, double& dt, const Eigen::Vector<double, 6>& state, Eigen::Vector<double, 6>& deriv,
+										astrokit::DenseStep<Eigen::Vector<double, 6>>& dense, double& dt_next);
+	//note: one accepted step with its continuous extension (DOPRI's built-in interpolant, cubic Hermite for RK4, quintic
+	//      orbit Hermite for RKF78). deriv must hold f(t, state) on entry and holds f(t + dt, new state) on return so the
+	//      next step reuses it. fixed-step RK4 takes dt as given; the adaptive methods behave like adaptive_step, except
+	//      that RKF78 steps also have to keep the extension itself within the tolerances (one extra evaluation per step)
+
+	Eigen::Vector<double, 6> propagate(double t0, double tf, const Eigen::Vector<double, 6>& state, double& dt_guess);
+	//note: adaptive integration from t0 to exactly tf; dt_guess seeds the first step (<= 0 lets the integrator pick)
+	//      and is updated with the predicted next step so consecutive calls carry the step size across output epochs
+
+	Eigen::Vector<double, 6> eoms(double t, const Eigen::Vector<double, 6>& state);
 
 private:
+	Eigen::Vector<double, 6> embedded_step(double t, double dt, const Eigen::Vector<double, 6>& state, const Eigen::Vector<double, 6>& k1,
+										   Eigen::Vector<double, 6>& err, Eigen::Vector<double, 6>& f_new,
+										   astrokit::DenseStep<Eigen::Vector<double, 6>>& dense);
+	Eigen::Vector<double, 6> controlled_step(double t, double& dt, const Eigen::Vector<double, 6>& state, Eigen::Vector<double, 6>& deriv,
+											 astrokit::DenseStep<Eigen::Vector<double, 6>>& dense, double& dt_next); //dense_step without RKF78's extension check
+	double error_norm(const Eigen::Vector<double, 6>& y0, const Eigen::Vector<double, 6>& y1, const Eigen::Vector<double, 6>& err) const;
+	int error_order() const; //order of the lower-order solution in the embedded pair (sets the step size exponent)
+
 	Planet& cb;
 	ForceModel& fm;
 
-};
\ No newline at end of file
+	IntegrationMethod method;
+	double rel_tol;
+	double abs_tol;
+};
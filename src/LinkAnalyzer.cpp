@@ -0,0 +1,441 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "LinkAnalyzer.h"
+#include "simd_utils.h"
+#include <astrokit/math_utils.h>
+#include <astrokit/integrators.h>
+
+LinkAnalyzer::LinkAnalyzer(Planet& cb) : cb(cb), max_range(0.0), grazing_margin(0.0), time_tol(1e-3)
+{
+}
+
+LinkAnalyzer::LinkAnalyzer(Planet& cb, double max_range, double grazing_margin, double time_tol) : cb(cb)
+{
+	set_max_range(max_range);
+	set_grazing_margin(grazing_margin);
+	set_time_tol(time_tol);
+}
+
+#pragma region getters
+double LinkAnalyzer::get_max_range() const
+{
+	return this->max_range;
+}
+
+double LinkAnalyzer::get_grazing_margin() const
+{
+	return this->grazing_margin;
+}
+
+double LinkAnalyzer::get_time_tol() const
+{
+	return this->time_tol;
+}
+#pragma endregion getters
+
+#pragma region setters
+void LinkAnalyzer::set_max_range(double new_max_range)
+{
+	if (new_max_range < 0.0)
+	{
+		throw std::runtime_error("Link max range can't be negative (0 = line of sight only).");
+	}
+	this->max_range = new_max_range;
+}
+
+void LinkAnalyzer::set_grazing_margin(double new_margin)
+{
+	this->grazing_margin = new_margin;
+}
+
+void LinkAnalyzer::set_time_tol(double new_time_tol)
+{
+	if (new_time_tol <= 0.0)
+	{
+		throw std::runtime_error("Link time tolerance must be positive.");
+	}
+	this->time_tol = new_time_tol;
+}
+#pragma endregion setters
+
+#pragma region utilities
+std::vector<LinkSample> LinkAnalyzer::compute_geometry(const std::vector<Spacecraft>& sats, std::size_t row) const
+{
+	std::vector<LinkSample> samples;
+	if (sats.size() < 2)
+	{
+		return samples;
+	}
+
+	Epoch epoch;
+	load_epoch(sats, row, epoch);
+	Candidates cand;
+	for (std::size_t i = 0; i < sats.size(); i++)
+	{
+		evaluate_candidates(epoch, i, false, cand);
+		for (std::size_t c = 0; c < cand.j.size(); c++)
+		{
+			const bool los = cand.grazing_altitude[c] >= this->grazing_margin;
+			samples.push_back({ i, cand.j[c], epoch.et, cand.range[c], cand.range_rate[c], cand.grazing_altitude[c], los,
+								link_margin(cand.range[c], cand.grazing_altitude[c]) >= 0.0 });
+		}
+	}
+	return samples;
+}
+
+std::vector<LinkInterval> LinkAnalyzer::compute_links(const std::vector<Spacecraft>& sats) const
+{
+	ThreadPool serial(1);
+	return compute_links(sats, serial);
+}
+
+std::vector<LinkInterval> LinkAnalyzer::compute_links(const std::vector<Spacecraft>& sats, ThreadPool& pool) const
+{
+	std::vector<LinkInterval> intervals;
+	if (sats.size() < 2)
+	{
+		return intervals;
+	}
+	HistoryArena::ConstColumn et = sats[0].get_et_history();
+	for (const auto& sc : sats)
+	{
+		HistoryArena::ConstColumn sc_et = sc.get_et_history();
+		if (sc_et.size() != et.size() || !std::equal(sc_et.begin(), sc_et.end(), et.begin()))
+		{
+			throw std::runtime_error("Link analysis needs every spacecraft on the same output epochs.");
+		}
+	}
+	const std::size_t n_rows = static_cast<std::size_t>(et.size());
+
+	//links that are currently up, sorted by partner; each spacecraft owns the pairs where it's sc_a, so a thread only
+	// ever touches the lists of its own spacecraft. the candidates also come out sorted by partner, so each epoch is a
+	// single merge of the two lists (no hashing)
+	struct OpenLink
+	{
+		std::uint32_t j;
+		double start_et;
+		double min_range;
+	};
+	std::vector<std::vector<OpenLink>> open(sats.size());
+	std::vector<std::vector<LinkInterval>> per_sc(sats.size());
+
+	//epochs are loaded a batch at a time (in parallel), then each thread runs its spacecraft through the whole batch,
+	// so there are two barriers per batch instead of one per epoch
+	std::vector<Epoch> batch(std::min(EPOCH_BATCH, n_rows));
+	for (std::size_t k0 = 0; k0 < n_rows; k0 += batch.size())
+	{
+		const std::size_t n_batch = std::min(batch.size(), n_rows - k0);
+		pool.parallel_for(n_batch, [&](std::size_t b0, std::size_t b1)
+		{
+			for (std::size_t b = b0; b < b1; b++)
+			{
+				load_epoch(sats, k0 + b, batch[b]);
+			}
+		});
+		pool.parallel_for(sats.size(), [&](std::size_t i0, std::size_t i1)
+		{
+			thread_local Candidates cand;
+			thread_local std::vector<OpenLink> still_open;
+			for (std::size_t i = i0; i < i1; i++)
+			{
+				std::vector<OpenLink>& links = open[i];
+				for (std::size_t k = k0; k < k0 + n_batch; k++)
+				{
+					const Epoch& epoch = batch[k - k0];
+					evaluate_candidates(epoch, i, true, cand);
+					still_open.clear();
+					std::size_t o = 0;
+					for (std::size_t c = 0; c < cand.j.size(); c++)
+					{
+						if (link_margin(cand.range[c], cand.grazing_altitude[c]) < 0.0)
+						{
+							continue;
+						}
+						//anything open with a lower partner wasn't seen this epoch; it went down inside the last step
+						for (; o < links.size() && links[o].j < cand.j[c]; o++)
+						{
+							per_sc[i].push_back({ i, links[o].j, links[o].start_et, refine(sats[i], sats[links[o].j], k - 1), links[o].min_range });
+						}
+						if (o < links.size() && links[o].j == cand.j[c])
+						{
+							still_open.push_back({ cand.j[c], links[o].start_et, std::min(links[o].min_range, cand.range[c]) });
+							o++;
+						}
+						else
+						{
+							double start = (k == 0) ? epoch.et : refine(sats[i], sats[cand.j[c]], k - 1);
+							still_open.push_back({ cand.j[c], start, cand.range[c] });
+						}
+					}
+					for (; o < links.size(); o++)
+					{
+						per_sc[i].push_back({ i, links[o].j, links[o].start_et, refine(sats[i], sats[links[o].j], k - 1), links[o].min_range });
+					}
+					links.swap(still_open);
+				}
+			}
+		});
+	}
+
+	//still up at the end of the history
+	for (std::size_t i = 0; i < sats.size(); i++)
+	{
+		for (const OpenLink& link : open[i])
+		{
+			per_sc[i].push_back({ i, link.j, link.start_et, et[n_rows - 1], link.min_range });
+		}
+		std::sort(per_sc[i].begin(), per_sc[i].end(), [](const LinkInterval& a, const LinkInterval& b)
+		{
+			return (a.sc_b != b.sc_b) ? a.sc_b < b.sc_b : a.start_et < b.start_et;
+		});
+		intervals.insert(intervals.end(), per_sc[i].begin(), per_sc[i].end());
+	}
+	return intervals;
+}
+
+void LinkAnalyzer::load_epoch(const std::vector<Spacecraft>& sats, std::size_t row, Epoch& epoch) const
+{
+	const std::size_t n = sats.size();
+	epoch.et = sats[0].get_history().et_at(row);
+	for (auto* v : { &epoch.x, &epoch.y, &epoch.z, &epoch.vx, &epoch.vy, &epoch.vz, &epoch.radius, &epoch.horizon_cos, &epoch.horizon_sin })
+	{
+		v->resize(n);
+	}
+	const double r_graze = this->cb.get_mean_radius() + this->grazing_margin;
+
+	double r2_max = 0.0;
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const Eigen::Vector<double, 6> cart = sats[i].get_history().cart_at(row);
+		epoch.x[i] = cart[0];
+		epoch.y[i] = cart[1];
+		epoch.z[i] = cart[2];
+		epoch.vx[i] = cart[3];
+		epoch.vy[i] = cart[4];
+		epoch.vz[i] = cart[5];
+		r2_max = std::max(r2_max, cart.head<3>().squaredNorm());
+
+		//a spacecraft sees over the grazing sphere out to acos(r_graze / r) from its own direction (nothing when it's
+		// inside it)
+		epoch.radius[i] = cart.head<3>().norm();
+		const double c = (r_graze > 0.0) ? std::min(r_graze / epoch.radius[i], 1.0) : 1.0; //(unused without a sphere)
+		epoch.horizon_cos[i] = c;
+		epoch.horizon_sin[i] = std::sqrt(1.0 - c * c);
+	}
+
+	//longest possible line of sight: both ends at r_max, tangent to the sphere of radius R + margin
+	epoch.link_range = 2.0 * std::sqrt(std::max(r2_max - r_graze * r_graze, 0.0));
+	if (this->max_range > 0.0)
+	{
+		epoch.link_range = std::min(epoch.link_range, this->max_range);
+	}
+	//dense grid over the cube [-r_max, r_max]^3, counting-sorted, so every cell (and every run of cells along z) is a
+	// contiguous slice of members
+	const double r_max = std::sqrt(r2_max);
+	epoch.cell_size = std::max(epoch.link_range / CELLS_PER_RANGE, 2.0 * r_max / MAX_CELLS_PER_AXIS);
+	if (!(epoch.cell_size > 0.0))
+	{
+		epoch.cell_size = 1.0; //every spacecraft at the center; any size works
+	}
+	epoch.grid_origin = -r_max;
+	epoch.cells_per_axis = static_cast<std::int64_t>(2.0 * r_max / epoch.cell_size) + 1;
+	const std::int64_t n_axis = epoch.cells_per_axis;
+	auto axis_cell = [&](double coordinate)
+	{
+		return std::clamp(static_cast<std::int64_t>(std::floor((coordinate - epoch.grid_origin) / epoch.cell_size)), std::int64_t(0), n_axis - 1);
+	};
+
+	epoch.cell_start.assign(static_cast<std::size_t>(n_axis * n_axis * n_axis) + 1, 0);
+	epoch.cell_of.resize(n);
+	for (std::size_t i = 0; i < n; i++)
+	{
+		epoch.cell_of[i] = static_cast<std::uint32_t>((axis_cell(epoch.x[i]) * n_axis + axis_cell(epoch.y[i])) * n_axis + axis_cell(epoch.z[i]));
+		epoch.cell_start[epoch.cell_of[i] + 1]++;
+	}
+	for (std::size_t c = 1; c < epoch.cell_start.size(); c++)
+	{
+		epoch.cell_start[c] += epoch.cell_start[c - 1];
+	}
+	epoch.members.resize(n);
+	std::vector<std::uint32_t> fill(epoch.cell_start.begin(), epoch.cell_start.end() - 1);
+	for (std::size_t i = 0; i < n; i++)
+	{
+		epoch.members[fill[epoch.cell_of[i]]++] = static_cast<std::uint32_t>(i);
+	}
+}
+
+void LinkAnalyzer::evaluate_candidates(const Epoch& epoch, std::size_t i, bool in_view_only, Candidates& out) const
+{
+	out.j.clear();
+	const double xi = epoch.x[i], yi = epoch.y[i], zi = epoch.z[i];
+	const double cs = epoch.cell_size;
+	const double range2 = epoch.link_range * epoch.link_range * (1.0 + 1e-9); //slack; the exact test below decides
+	const std::int64_t n_axis = epoch.cells_per_axis;
+	auto axis_cell = [&](double coordinate)
+	{
+		return std::clamp(static_cast<std::int64_t>(std::floor((coordinate - epoch.grid_origin) / cs)), std::int64_t(0), n_axis - 1);
+	};
+	const bool horizon_cull = in_view_only && this->cb.get_mean_radius() + this->grazing_margin > 0.0;
+
+	//each (x, y) column of cells is contiguous along z, so a column that comes within link range is one slice of the
+	// members, trimmed to the z span that can
+	const double link_range = std::sqrt(range2);
+	for (std::int64_t cx = axis_cell(xi - link_range); cx <= axis_cell(xi + link_range); cx++)
+	{
+		const double x_lo = epoch.grid_origin + cx * cs;
+		const double gap_x = std::max({ x_lo - xi, xi - (x_lo + cs), 0.0 });
+		for (std::int64_t cy = axis_cell(yi - link_range); cy <= axis_cell(yi + link_range); cy++)
+		{
+			const double y_lo = epoch.grid_origin + cy * cs;
+			const double gap_y = std::max({ y_lo - yi, yi - (y_lo + cs), 0.0 });
+			const double left2 = range2 - gap_x * gap_x - gap_y * gap_y;
+			if (left2 < 0.0)
+			{
+				continue;
+			}
+			const double dz = std::sqrt(left2);
+			const std::int64_t column = (cx * n_axis + cy) * n_axis;
+			const std::uint32_t first = epoch.cell_start[static_cast<std::size_t>(column + axis_cell(zi - dz))];
+			const std::uint32_t last = epoch.cell_start[static_cast<std::size_t>(column + axis_cell(zi + dz)) + 1];
+			for (std::uint32_t m = first; m < last; m++)
+			{
+				const std::size_t j = epoch.members[m];
+				if (j <= i)
+				{
+					continue;
+				}
+
+				//cheap pre-cull: out of range, or (for links) past both horizons, i.e. the angle between the two
+				// position vectors is more than the sum of their horizon half-angles
+				const double dot = xi * epoch.x[j] + yi * epoch.y[j] + zi * epoch.z[j];
+				const double rr = epoch.radius[i] * epoch.radius[j];
+				if (epoch.radius[i] * epoch.radius[i] + epoch.radius[j] * epoch.radius[j] - 2.0 * dot > range2)
+				{
+					continue;
+				}
+				const double cos_sum = epoch.horizon_cos[i] * epoch.horizon_cos[j] - epoch.horizon_sin[i] * epoch.horizon_sin[j];
+				if (horizon_cull && dot < rr * (cos_sum - 1e-9))
+				{
+					continue;
+				}
+				out.j.push_back(static_cast<std::uint32_t>(j));
+			}
+		}
+	}
+
+	std::sort(out.j.begin(), out.j.end()); //partner order, so results don't depend on how the grid happened to fall
+
+	//gather the partners into contiguous lanes; padding lanes sit far away so they never look linked
+	const std::size_t n = out.j.size();
+	const std::size_t n_lanes = simd::padded_size(n);
+	for (auto* v : { &out.x, &out.y, &out.z, &out.vx, &out.vy, &out.vz, &out.range, &out.range_rate, &out.grazing_altitude })
+	{
+		v->resize(n_lanes);
+	}
+	for (std::size_t c = 0; c < n_lanes; c++)
+	{
+		const bool pad = c >= n;
+		const std::size_t j = pad ? i : out.j[c];
+		out.x[c] = epoch.x[j] + (pad ? 1e12 : 0.0);
+		out.y[c] = epoch.y[j];
+		out.z[c] = epoch.z[j];
+		out.vx[c] = epoch.vx[j];
+		out.vy[c] = epoch.vy[j];
+		out.vz[c] = epoch.vz[j];
+	}
+
+	const simd::vec x0 = simd::broadcast(xi), y0 = simd::broadcast(yi), z0 = simd::broadcast(zi);
+	const simd::vec vx0 = simd::broadcast(epoch.vx[i]), vy0 = simd::broadcast(epoch.vy[i]), vz0 = simd::broadcast(epoch.vz[i]);
+	const simd::vec zero = simd::broadcast(0.0), one = simd::broadcast(1.0);
+	const simd::vec radius = simd::broadcast(this->cb.get_mean_radius());
+	for (std::size_t c = 0; c < n_lanes; c += simd::WIDTH)
+	{
+		const simd::vec dx = simd::load(&out.x[c]) - x0;
+		const simd::vec dy = simd::load(&out.y[c]) - y0;
+		const simd::vec dz = simd::load(&out.z[c]) - z0;
+		const simd::vec dvx = simd::load(&out.vx[c]) - vx0;
+		const simd::vec dvy = simd::load(&out.vy[c]) - vy0;
+		const simd::vec dvz = simd::load(&out.vz[c]) - vz0;
+
+		const simd::vec range2 = dx * dx + dy * dy + dz * dz;
+		const simd::vec range = simd::sqrt(range2);
+		simd::store(&out.range[c], range);
+		simd::store(&out.range_rate[c], (dx * dvx + dy * dvy + dz * dvz) / range);
+
+		//closest point of the segment r_i + s * (r_j - r_i), s in [0, 1], to the center of the body
+		const simd::vec s = simd::min(simd::max(zero - (x0 * dx + y0 * dy + z0 * dz) / range2, zero), one);
+		const simd::vec px = x0 + s * dx;
+		const simd::vec py = y0 + s * dy;
+		const simd::vec pz = z0 + s * dz;
+		simd::store(&out.grazing_altitude[c], simd::sqrt(px * px + py * py + pz * pz) - radius);
+	}
+
+	//the pre-cull above was slightly generous; only pairs within link range are left
+	std::size_t kept = 0;
+	for (std::size_t c = 0; c < n; c++)
+	{
+		if (out.range[c] <= epoch.link_range)
+		{
+			out.j[kept] = out.j[c];
+			out.range[kept] = out.range[c];
+			out.range_rate[kept] = out.range_rate[c];
+			out.grazing_altitude[kept] = out.grazing_altitude[c];
+			kept++;
+		}
+	}
+	out.j.resize(kept);
+}
+
+double LinkAnalyzer::link_margin(double range, double grazing_altitude) const
+{
+	double margin = grazing_altitude - this->grazing_margin;
+	if (this->max_range > 0.0)
+	{
+		margin = std::min(margin, this->max_range - range);
+	}
+	return margin;
+}
+
+double LinkAnalyzer::refine(const Spacecraft& a, const Spacecraft& b, std::size_t row) const
+{
+	const HistoryArena& ha = a.get_history();
+	const HistoryArena& hb = b.get_history();
+	const double t0 = ha.et_at(row);
+	const double t1 = ha.et_at(row + 1);
+	const double dt = t1 - t0;
+	if (dt == 0.0) //zero-length step (e.g. a burn logged as its own row)
+	{
+		return t1;
+	}
+
+	auto interpolant = [&](const HistoryArena& h)
+	{
+		const Eigen::Vector<double, 6> c0 = h.cart_at(row);
+		const Eigen::Vector<double, 6> c1 = h.cart_at(row + 1);
+		astrokit::DenseStep<Eigen::Vector3d> pos;
+		astrokit::hermite_dense<Eigen::Vector3d>(t0, dt, c0.head<3>(), c0.tail<3>(), c1.head<3>(), c1.tail<3>(), pos);
+		return pos;
+	};
+	const astrokit::DenseStep<Eigen::Vector3d> pa = interpolant(ha);
+	const astrokit::DenseStep<Eigen::Vector3d> pb = interpolant(hb);
+	const double radius = this->cb.get_mean_radius();
+	auto margin_at = [&](double t)
+	{
+		const Eigen::Vector3d ra = pa.evaluate(t);
+		const Eigen::Vector3d d = pb.evaluate(t) - ra;
+		const double s = std::clamp(-ra.dot(d) / d.squaredNorm(), 0.0, 1.0);
+		return link_margin(d.norm(), (ra + s * d).norm() - radius);
+	};
+
+	const double f0 = margin_at(t0);
+	const double f1 = margin_at(t1);
+	if ((f0 < 0.0) == (f1 < 0.0))
+	{
+		return t1; //the change sits right at a sample (scalar & SIMD rounding disagree about which side); no bracket to refine
+	}
+	return astrokit::find_root(margin_at, t0, t1, f0, f1, this->time_tol);
+}
+
+#pragma endregion utilities
@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <Eigen/Dense>
+#include "structure_definitions.h"
+#include "Planet.h"
+#include "Spacecraft.h"
+#include "ThreadPool.h"
+
+class LinkAnalyzer
+{
+public:
+	//inter-satellite link (ISL) geometry across the whole constellation from the propagated histories
+	//a pair is linked when the line of sight clears the central body by at least grazing_margin and the range is within
+	// max_range. no pair can be linked beyond the line-of-sight limit 2 * sqrt(r_max^2 - (R + margin)^2) (or max_range
+	// when that's shorter), so each output epoch the spacecraft are binned into a uniform grid with cells half that size
+	// and only the cells that reach within link range are searched. candidates are pre-culled on range (and, for
+	// compute_links, on whether the two horizons overlap) before the survivors are evaluated in SIMD batches (range,
+	// range-rate, grazing altitude). link up/down times are refined with Brent's method on cubic Hermite interpolants of
+	// both states, like AccessAnalyzer's rise/set times
+	//note: every spacecraft has to be on the same output grid (lockstep propagation)
+	//note: the search is roughly N * (spacecraft within link range) per epoch, so the grid only pays off when the link
+	//      range is well below the orbit radius (e.g. a terminal max_range of a few thousand km in LEO). with no
+	//      max_range the line-of-sight limit in LEO is ~5000 km, which takes in 10-15% of a shell, and for MEO/GEO most
+	//      pairs really are in view of each other. the search is then close to N^2 / 2 because the links themselves are
+	//      (pruning on a Walker plane/slot layout instead would drop real links, so it's all geometry)
+	LinkAnalyzer(Planet& cb);
+	LinkAnalyzer(Planet& cb, double max_range, double grazing_margin, double time_tol);
+
+	//getters
+	double get_max_range() const;
+	double get_grazing_margin() const;
+	double get_time_tol() const;
+
+	//setters
+	void set_max_range(double new_max_range); //[km]; 0 = no limit beyond line of sight
+	void set_grazing_margin(double new_margin); //[km]; altitude the line of sight has to clear (e.g. ~100 km of atmosphere)
+	void set_time_tol(double new_time_tol);
+
+	//utilities
+	std::vector<LinkSample> compute_geometry(const std::vector<Spacecraft>& sats, std::size_t row) const;
+	//note: every pair within link range at history row `row` (line of sight or not), ordered by sc_a, then sc_b
+	std::vector<LinkInterval> compute_links(const std::vector<Spacecraft>& sats) const;
+	std::vector<LinkInterval> compute_links(const std::vector<Spacecraft>& sats, ThreadPool& pool) const;
+	//note: intervals are ordered by sc_a, then sc_b, then start time. the pool loads a batch of epochs, then splits the
+	//      spacecraft across threads for the whole batch (results don't depend on the thread count)
+
+private:
+	struct Epoch //every spacecraft's state at one output row, structure-of-arrays, plus the search grid
+	{
+		double et;
+		std::vector<double> x, y, z, vx, vy, vz;
+		std::vector<double> radius; //|r|
+		std::vector<double> horizon_cos, horizon_sin; //half-angle a spacecraft sees over the grazing sphere (acos((R + margin) / r))
+		double link_range; //no pair beyond this can be linked
+		double cell_size;
+		double grid_origin; //[km]; corner of the grid (-r_max on every axis)
+		std::int64_t cells_per_axis;
+		std::vector<std::uint32_t> cell_start; //cell (x, y, z) holds members [cell_start[c], cell_start[c + 1]), c = (x * n + y) * n + z, n = cells_per_axis
+		std::vector<std::uint32_t> members; //spacecraft indices in cell order
+		std::vector<std::uint32_t> cell_of; //each spacecraft's cell
+	};
+
+	static constexpr int CELLS_PER_RANGE = 2; //grid cells per link range (finer follows a shell more closely, but costs more columns)
+	static constexpr std::int64_t MAX_CELLS_PER_AXIS = 64; //caps the grid's memory when the link range is short
+	static constexpr std::size_t EPOCH_BATCH = 16; //epochs compute_links loads & works through per pair of pool barriers
+
+	struct Candidates //SIMD-evaluated pairs (i, j > i) within link range of one spacecraft
+	{
+		std::vector<std::uint32_t> j;
+		std::vector<double> x, y, z, vx, vy, vz; //gathered partner states (padded to whole SIMD lanes)
+		std::vector<double> range, range_rate, grazing_altitude;
+	};
+
+	void load_epoch(const std::vector<Spacecraft>& sats, std::size_t row, Epoch& epoch) const;
+	void evaluate_candidates(const Epoch& epoch, std::size_t i, bool in_view_only, Candidates& out) const;
+	//note: in_view_only also drops pairs whose line of sight is blocked (anything that can't be linked)
+	double link_margin(double range, double grazing_altitude) const; //>= 0 when linked
+	double refine(const Spacecraft& a, const Spacecraft& b, std::size_t row) const; //link change inside [row, row + 1]
+
+	Planet& cb;
+	double max_range;
+	double grazing_margin;
+	double time_tol; //[s]; link up/down times are refined to within this
+};
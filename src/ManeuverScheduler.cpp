@@ -0,0 +1,163 @@
+#include <cmath>
+#include "ManeuverScheduler.h"
+#include <astrokit/kepler.h>
+
+ManeuverScheduler::ManeuverScheduler() : ManeuverScheduler(0.0, 10.0)
+{
+}
+
+ManeuverScheduler::ManeuverScheduler(double lead_time, double phasing_drift_periods) :
+	lead_time(lead_time), phasing_drift_periods(phasing_drift_periods), queue(), next_sequence(0), pending(), ledger(), total_dv()
+{
+}
+
+#pragma region getters
+double ManeuverScheduler::get_lead_time() const
+{
+	return this->lead_time;
+}
+
+double ManeuverScheduler::get_phasing_drift_periods() const
+{
+	return this->phasing_drift_periods;
+}
+
+std::size_t ManeuverScheduler::get_pending_count() const
+{
+	return this->queue.size();
+}
+
+bool ManeuverScheduler::has_pending(std::size_t sc_index) const
+{
+	return sc_index < this->pending.size() && this->pending[sc_index] > 0;
+}
+
+const std::vector<Maneuver>& ManeuverScheduler::get_ledger() const
+{
+	return this->ledger;
+}
+
+double ManeuverScheduler::get_total_dv(std::size_t sc_index) const
+{
+	return (sc_index < this->total_dv.size()) ? this->total_dv[sc_index] : 0.0;
+}
+#pragma endregion getters
+
+#pragma region setters
+void ManeuverScheduler::set_lead_time(double new_lead_time)
+{
+	this->lead_time = new_lead_time;
+}
+
+void ManeuverScheduler::set_phasing_drift_periods(double new_periods)
+{
+	this->phasing_drift_periods = new_periods;
+}
+#pragma endregion setters
+
+#pragma region utilities
+void ManeuverScheduler::plan(std::size_t sc_index, const Spacecraft& sc, const BoundsCheck& violations, double et, double mu, double raan_offset)
+{
+	const TrackingState now = sc.get_tracking();
+	const TrackingState ref = sc.get_tracking_ref();
+	const State state = sc.get_state();
+	const double v = state.vel.norm();
+	const double a = now.sma_mean;
+	const double n = std::sqrt(mu / (a * a * a));
+	const double et_burn = et + this->lead_time;
+
+	if (violations.sma)
+	{
+		//da/a = 2 dv/v for a tangential burn on a near-circular orbit
+		double dv_t = 0.5 * v * (ref.sma_mean - now.sma_mean) / a;
+		schedule(Maneuver{ et_burn, sc_index, ManeuverType::sma, Eigen::Vector3d(0.0, dv_t, 0.0) });
+	}
+
+	if (violations.inc || violations.raan)
+	{
+		//a normal burn at argument of latitude u changes inc by dv cos(u) / v & raan by dv sin(u) / (v sin(inc)), so
+		// both errors are fixed at once where (cos u, sin u) lines up with (dinc, sin(inc) draan)
+		double dinc = ref.inc_mean - now.inc_mean;
+		double draan_sin_i = -(sc.get_raan_error() - raan_offset) * std::sin(now.inc_mean);
+		double u_burn = std::atan2(draan_sin_i, dinc);
+		double dv_n = v * std::hypot(dinc, draan_sin_i);
+
+		//time until we get there (at least lead_time out)
+		double u_now = astrokit::wrap_2pi(state.argp + state.ta);
+		double dt = astrokit::wrap_2pi(u_burn - u_now) / n;
+		if (dt < this->lead_time)
+		{
+			dt += std::ceil((this->lead_time - dt) * n / (2.0 * astrokit::PI)) * 2.0 * astrokit::PI / n;
+		}
+		schedule(Maneuver{ et + dt, sc_index, ManeuverType::plane, Eigen::Vector3d(0.0, 0.0, dv_n) });
+	}
+
+	if (violations.arglat)
+	{
+		//neighbor1 is the next spacecraft along the plane; a growing angle means we're falling behind, so drop a little
+		// lower (faster) for the drift time: dn = -3/2 n da/a
+		double drift_time = this->phasing_drift_periods * sc.get_ref_period();
+		double phase_error = now.neighbor1_rel_angle - ref.neighbor1_rel_angle;
+		double da = -2.0 / 3.0 * a * (phase_error / drift_time) / n;
+		double dv_t = 0.5 * v * da / a;
+		schedule(Maneuver{ et_burn, sc_index, ManeuverType::phasing_start, Eigen::Vector3d(0.0, dv_t, 0.0) });
+		schedule(Maneuver{ et_burn + drift_time, sc_index, ManeuverType::phasing_stop, Eigen::Vector3d(0.0, -dv_t, 0.0) });
+	}
+}
+
+void ManeuverScheduler::schedule(const Maneuver& maneuver)
+{
+	ensure_size(maneuver.sc_index);
+	this->queue.push(Entry{ maneuver, this->next_sequence++ });
+	this->pending[maneuver.sc_index]++;
+}
+
+std::vector<Maneuver> ManeuverScheduler::pop_due(double et)
+{
+	std::vector<Maneuver> due;
+	while (!this->queue.empty() && this->queue.top().maneuver.et <= et)
+	{
+		due.push_back(this->queue.top().maneuver);
+		this->pending[due.back().sc_index]--;
+		this->queue.pop();
+	}
+	return due;
+}
+
+void ManeuverScheduler::record(const Maneuver& executed)
+{
+	ensure_size(executed.sc_index);
+	this->ledger.push_back(executed);
+	this->total_dv[executed.sc_index] += executed.dv_rtn.norm();
+}
+
+void ManeuverScheduler::clear()
+{
+	this->queue = std::priority_queue<Entry, std::vector<Entry>, Later>();
+	this->pending.clear();
+	this->ledger.clear();
+	this->total_dv.clear();
+}
+
+bool ManeuverScheduler::Later::operator()(const Entry& a, const Entry& b) const
+{
+	if (a.maneuver.et != b.maneuver.et)
+	{
+		return a.maneuver.et > b.maneuver.et;
+	}
+	if (a.maneuver.sc_index != b.maneuver.sc_index)
+	{
+		return a.maneuver.sc_index > b.maneuver.sc_index;
+	}
+	return a.sequence > b.sequence;
+}
+
+void ManeuverScheduler::ensure_size(std::size_t sc_index)
+{
+	if (sc_index >= this->pending.size())
+	{
+		this->pending.resize(sc_index + 1, 0);
+		this->total_dv.resize(sc_index + 1, 0.0);
+	}
+}
+#pragma endregion utilities
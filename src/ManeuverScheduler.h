@@ -0,0 +1,67 @@
+#pragma once
+#include <queue>
+#include <vector>
+#include <cstdint>
+#include "structure_definitions.h"
+#include "Spacecraft.h"
+
+class ManeuverScheduler
+{
+public:
+	//station-keeping burns for a constellation: plan turns a spacecraft's bounding box violations into impulsive burns,
+	// which wait in a priority queue (earliest epoch first) until the propagation reaches them; executed burns go into
+	// a ledger with a running delta-v total per spacecraft
+	//burn sizing uses the near-circular Gauss variational equations on the tracking means:
+	//  sma:     one tangential burn, dv = v/2 * da/a
+	//  inc/raan: one normal burn, placed at the argument of latitude where it fixes both at once
+	//  arglat:  a tangential burn that sets up a drift back to the reference phasing over phasing_drift_periods
+	//           reference periods, then an equal & opposite burn to stop it
+	//note: a spacecraft with burns still queued isn't planned for again; the ordering (epoch, then spacecraft index,
+	//      then planning order) is deterministic, so runs repeat exactly
+	ManeuverScheduler();
+	ManeuverScheduler(double lead_time, double phasing_drift_periods);
+
+	//getters
+	double get_lead_time() const;
+	double get_phasing_drift_periods() const;
+	std::size_t get_pending_count() const; //burns still queued
+	bool has_pending(std::size_t sc_index) const;
+	const std::vector<Maneuver>& get_ledger() const; //executed burns in the order they were applied
+	double get_total_dv(std::size_t sc_index) const; //[km/s]; sum of the executed burn magnitudes
+
+	//setters
+	void set_lead_time(double new_lead_time); //[s]; earliest a burn can follow the violation it corrects
+	void set_phasing_drift_periods(double new_periods);
+
+	//utilities
+	void plan(std::size_t sc_index, const Spacecraft& sc, const BoundsCheck& violations, double et, double mu, double raan_offset);
+	//note: raan_offset is the same offset Spacecraft::check_bounds was given; the plane burn corrects get_raan_error - raan_offset
+	void schedule(const Maneuver& maneuver);
+	std::vector<Maneuver> pop_due(double et); //every queued burn scheduled at or before et, in execution order
+	void record(const Maneuver& executed); //ledger entry; et should be the epoch it was actually applied at
+	void clear(); //drops the queue, the ledger & the totals
+
+private:
+	struct Entry
+	{
+		Maneuver maneuver;
+		std::uint64_t sequence; //planning order; last tie-breaker
+	};
+
+	struct Later //priority_queue keeps the "largest" on top, so order by "happens later"
+	{
+		bool operator()(const Entry& a, const Entry& b) const;
+	};
+
+	void ensure_size(std::size_t sc_index);
+
+	double lead_time;
+	double phasing_drift_periods;
+
+	std::priority_queue<Entry, std::vector<Entry>, Later> queue;
+	std::uint64_t next_sequence;
+	std::vector<std::size_t> pending; //queued burns per spacecraft
+
+	std::vector<Maneuver> ledger;
+	std::vector<double> total_dv;
+};
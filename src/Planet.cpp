@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Planet.h"
 
 Planet::Planet(SpiceHandler& spice) :
@@ -72,6 +73,21 @@ const std::vector<GroundStation>& Planet::get_stations() const
 {
 	return this->stations;
 }
+
+const RotationCache* Planet::get_rotation_cache() const
+{
+	return this->rotation_cache.get();
+}
+
+const EphemerisCache* Planet::get_ephemeris_cache() const
+{
+	return this->ephemeris_cache.get();
+}
+
+const GravityField* Planet::get_gravity_field() const
+{
+	return this->gravity_field.get();
+}
 #pragma endregion getters
 
 #pragma region setters
@@ -132,25 +148,100 @@ void Planet::remove_station(double lon, double lat)
 	}
 }
 
-Eigen::Vector3d Planet::sun_vector(double et)
+Eigen::Vector3d Planet::sun_vector(double et) const
 {
-	Eigen::Vector3d r_sun = spice.fetch_pos(et, 10, this->spkid, "J2000");
+	Eigen::Vector3d r_sun = body_position(10, et);
 
 	return r_sun.normalized();
 }
 
-Eigen::Matrix3d Planet::icrf_R_bcf(double et)
+Eigen::Vector3d Planet::body_position(int body_spkid, double et) const
+{
+	if (this->ephemeris_cache && this->ephemeris_cache->covers(et) && this->ephemeris_cache->has_body(body_spkid))
+	{
+		return this->ephemeris_cache->position(body_spkid, et);
+	}
+	return spice.fetch_pos(et, body_spkid, this->spkid, "J2000");
+}
+
+std::vector<Eigen::Vector3d> Planet::body_positions(int body_spkid, const std::vector<double>& ets) const
+{
+	std::vector<Eigen::Vector3d> positions;
+	if (this->ephemeris_cache && !ets.empty() && this->ephemeris_cache->has_body(body_spkid) 
+		&& this->ephemeris_cache->covers(*std::min_element(ets.begin(), ets.end())) 
+		&& this->ephemeris_cache->covers(*std::max_element(ets.begin(), ets.end())))
+	{
+		this->ephemeris_cache->positions(body_spkid, ets, positions);
+		return positions;
+	}
+
+	positions.reserve(ets.size());
+	for (double et : ets)
+	{
+		positions.push_back(body_position(body_spkid, et));
+	}
+	return positions;
+}
+
+Eigen::Matrix3d Planet::icrf_R_bcf(double et) const
 {
+	if (this->rotation_cache && this->rotation_cache->covers(et))
+	{
+		return this->rotation_cache->rotation(et);
+	}
 	Eigen::Matrix3d icrf_C_bcf = spice.fetch_rot_matrix(et, "J2000", this->bcf_frame_name);
 	
 	return icrf_C_bcf;
 }
 
-Eigen::Matrix3d Planet::bcf_R_icrf(double et)
+std::vector<Eigen::Matrix3d> Planet::icrf_R_bcf(const std::vector<double>& ets) const
+{
+	std::vector<Eigen::Matrix3d> icrf_C_bcf;
+	if (this->rotation_cache && !ets.empty() && this->rotation_cache->covers(*std::min_element(ets.begin(), ets.end())) 
+		&& this->rotation_cache->covers(*std::max_element(ets.begin(), ets.end())))
+	{
+		this->rotation_cache->rotations(ets, icrf_C_bcf);
+		return icrf_C_bcf;
+	}
+
+	icrf_C_bcf.reserve(ets.size());
+	for (double et : ets)
+	{
+		icrf_C_bcf.push_back(icrf_R_bcf(et));
+	}
+	return icrf_C_bcf;
+}
+
+Eigen::Matrix3d Planet::bcf_R_icrf(double et) const
 {
 	Eigen::Matrix3d bcf_C_icrf = icrf_R_bcf(et).transpose();
 	
 	return bcf_C_icrf;
 }
 
+void Planet::cache_rotations(double et0, double etf)
+{
+	this->rotation_cache = std::make_unique<RotationCache>(this->spice, "J2000", this->bcf_frame_name, et0, etf);
+}
+
+void Planet::cache_rotations(double et0, double etf, double initial_step, double max_error)
+{
+	this->rotation_cache = std::make_unique<RotationCache>(this->spice, "J2000", this->bcf_frame_name, et0, etf, initial_step, max_error);
+}
+
+void Planet::cache_ephemeris(double et0, double etf, std::vector<int> bodies)
+{
+	this->ephemeris_cache = std::make_unique<EphemerisCache>(this->spice, bodies, this->spkid, "J2000", et0, etf);
+}
+
+void Planet::load_gravity_field(std::string file_name, int max_degree)
+{
+	this->gravity_field = std::make_unique<GravityField>(file_name, max_degree);
+}
+
+void Planet::load_gravity_field(std::string file_name, int max_degree, double field_mu, double field_radius)
+{
+	this->gravity_field = std::make_unique<GravityField>(file_name, max_degree, field_mu, field_radius);
+}
+
 #pragma endregion utilities
\ No newline at end of file
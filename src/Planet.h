@@ -2,9 +2,13 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <memory>
 #include <Eigen/Dense>
 #include "SpiceHandler.h"
 #include "GroundStation.h"
+#include "RotationCache.h"
+#include "EphemerisCache.h"
+#include "GravityField.h"
 
 class Planet
 {
@@ -28,6 +32,9 @@ public:
 	int get_spkid() const;
 	std::string get_bcf_frame_name() const;
 	const std::vector<GroundStation>& get_stations() const;
+	const RotationCache* get_rotation_cache() const; //nullptr until cache_rotations is called
+	const EphemerisCache* get_ephemeris_cache() const; //nullptr until cache_ephemeris is called
+	const GravityField* get_gravity_field() const; //nullptr until load_gravity_field is called
 
 	//setters
 	void set_mu(double new_mu);
@@ -42,17 +49,30 @@ public:
 	void new_station(std::string name, double lon, double lat, double half_angle);
 	void remove_station(double lon, double lat); //assumes only 1 station per lat/lon location
 	
-	Eigen::Vector3d sun_vector(double et); //unit vector from the center of the planet to the sun
+	Eigen::Vector3d sun_vector(double et) const; //unit vector from the center of the planet to the sun
+	Eigen::Vector3d body_position(int body_spkid, double et) const; //J2000 position of another body relative to the planet [km]
+	std::vector<Eigen::Vector3d> body_positions(int body_spkid, const std::vector<double>& ets) const; //batch version; one lookup per epoch
+	//note: both come from the ephemeris cache for bodies & epochs it covers, and straight from SPICE otherwise
+	//      (all of the ephemeris/rotation queries are safe from worker threads; cache hits never take the SPICE lock)
 	//note: rotation matrices follow the convection v_new = C * v_old
-	Eigen::Matrix3d icrf_R_bcf(double et);
-	Eigen::Matrix3d bcf_R_icrf(double et);
+	Eigen::Matrix3d icrf_R_bcf(double et) const;
+	Eigen::Matrix3d bcf_R_icrf(double et) const;
+	std::vector<Eigen::Matrix3d> icrf_R_bcf(const std::vector<double>& ets) const; //batch version; one lookup per epoch
+	//note: the rotations come from the rotation cache for epochs it covers, and straight from SPICE otherwise
+
+	void cache_rotations(double et0, double etf); //precompute icrf -> bcf over [et0, etf] (600 s grid, 1e-10 rad bound)
+	void cache_rotations(double et0, double etf, double initial_step, double max_error); //see RotationCache
+	void cache_ephemeris(double et0, double etf, std::vector<int> bodies); //Chebyshev fits relative to the planet (e.g. {10, 301})
+	void load_gravity_field(std::string file_name, int max_degree); //spherical harmonic coefficients (ICGEM .gfc), loaded once
+	void load_gravity_field(std::string file_name, int max_degree, double field_mu, double field_radius); //headerless tables
+	//note: the field is only used once a ForceModel asks for it (ForceModel::set_gravity_degree)
 	
 private:
 	double mu;
 	double mean_radius; //assuming a perfect spheroid for the body model (lat/lon computations & altitude)
 	double j2;     //assuming an oblate spheroid for the gravity modeling
 	double eq_radius; //need the equatorial radius for J2 EOMs
-	//note: future work; model an oblate spheroid or upgrade to a full obj file & higher-order gravity
+	//note: future work; model an oblate spheroid or upgrade to a full obj file (higher-order gravity is in gravity_field)
 
 	int spkid; //spice id
 	std::string bcf_frame_name; //e.g. 'IAU_EARTH', 'IAU_MARS', etc.; the spice name for the planet's BCF frame
@@ -60,6 +80,10 @@ private:
 
 	std::vector<GroundStation> stations; //variable number of ground stations
 
+	std::unique_ptr<RotationCache> rotation_cache; //interpolated icrf -> bcf rotations for the run's time span
+	std::unique_ptr<EphemerisCache> ephemeris_cache; //fitted positions of other bodies for the run's time span
+	std::unique_ptr<GravityField> gravity_field; //spherical harmonic coefficients; shared by every ForceModel on this planet
+
 	SpiceHandler& spice; //just a reference here; singleton pattern for SpiceHandler
 };
 
@@ -0,0 +1,166 @@
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "RotationCache.h"
+#include <astrokit/math_utils.h>
+
+RotationCache::RotationCache(SpiceHandler& spice, std::string from_frame, std::string to_frame, double et0, double etf) :
+	RotationCache(spice, from_frame, to_frame, et0, etf, 600.0, 1e-10)
+{
+}
+
+RotationCache::RotationCache(SpiceHandler& spice, std::string from_frame, std::string to_frame, double et0, double etf,
+							 double initial_step, double max_error) :
+	spice(spice), et0(et0), etf(etf), step(initial_step), max_error(max_error), achieved_error(0.0)
+{
+	if (etf <= et0 || initial_step <= 0.0 || max_error <= 0.0)
+	{
+		throw std::runtime_error("RotationCache needs et0 < etf, a positive step, and a positive error bound.");
+	}
+
+	//resolve the frames once; also catches typos before thousands of pxform_c calls
+	this->from_frame_id = spice.frame_id(from_frame);
+	this->to_frame_id = spice.frame_id(to_frame);
+	this->from_frame = spice.frame_name(this->from_frame_id);
+	this->to_frame = spice.frame_name(this->to_frame_id);
+
+	//halve the spacing until slerp meets the accuracy bound
+	//note: a body rotating at a constant rate about a fixed pole is reproduced exactly; the error comes from
+	//      precession/nutation terms, so this normally settles on the first or second pass
+	const double min_step = 1.0; //[s]; don't let a bad bound blow up the table
+	build(initial_step);
+	this->achieved_error = midpoint_error();
+	while (this->achieved_error > this->max_error && this->step > min_step)
+	{
+		build(std::max(0.5 * this->step, min_step));
+		this->achieved_error = midpoint_error();
+	}
+	if (this->achieved_error > this->max_error)
+	{
+		throw std::runtime_error("RotationCache couldn't reach the requested accuracy for " + this->from_frame + " -> " + this->to_frame + ".");
+	}
+}
+
+#pragma region getters
+int RotationCache::get_from_frame_id() const
+{
+	return this->from_frame_id;
+}
+
+int RotationCache::get_to_frame_id() const
+{
+	return this->to_frame_id;
+}
+
+double RotationCache::get_et0() const
+{
+	return this->et0;
+}
+
+double RotationCache::get_etf() const
+{
+	return this->etf;
+}
+
+double RotationCache::get_step() const
+{
+	return this->step;
+}
+
+double RotationCache::get_max_error() const
+{
+	return this->max_error;
+}
+
+double RotationCache::get_achieved_error() const
+{
+	return this->achieved_error;
+}
+
+std::size_t RotationCache::get_node_count() const
+{
+	return this->nodes.size();
+}
+#pragma endregion getters
+
+#pragma region utilities
+bool RotationCache::covers(double et) const
+{
+	return et >= this->et0 && et <= this->etf;
+}
+
+Eigen::Quaterniond RotationCache::quaternion(double et) const
+{
+	if (!covers(et))
+	{
+		throw std::runtime_error("Epoch outside of the RotationCache span for " + this->from_frame + " -> " + this->to_frame + ".");
+	}
+	//the last node sits at or past etf, so i + 1 always exists
+	double x = (et - this->et0) / this->step;
+	std::size_t i = std::min(static_cast<std::size_t>(x), this->nodes.size() - 2);
+	return this->nodes[i].slerp(x - static_cast<double>(i), this->nodes[i + 1]);
+}
+
+Eigen::Matrix3d RotationCache::rotation(double et) const
+{
+	return quaternion(et).toRotationMatrix();
+}
+
+void RotationCache::rotations(const std::vector<double>& ets, std::vector<Eigen::Matrix3d>& out) const
+{
+	out.resize(ets.size());
+	for (std::size_t k = 0; k < ets.size(); k++)
+	{
+		out[k] = rotation(ets[k]);
+	}
+}
+
+Eigen::Vector3d RotationCache::rotate(double et, const Eigen::Vector3d& v) const
+{
+	return quaternion(et) * v;
+}
+
+double RotationCache::check_accuracy(std::size_t n_samples)
+{
+	double worst = 0.0;
+	for (std::size_t k = 0; k < n_samples; k++)
+	{
+		double et = astrokit::random_double(this->et0, this->etf);
+		Eigen::Quaterniond truth(this->spice.fetch_rot_matrix(et, this->from_frame, this->to_frame));
+		worst = std::max(worst, quaternion(et).angularDistance(truth));
+	}
+	return worst;
+}
+
+void RotationCache::build(double step)
+{
+	this->step = step;
+	std::size_t n_nodes = static_cast<std::size_t>(std::ceil((this->etf - this->et0) / step)) + 1;
+	n_nodes = std::max<std::size_t>(n_nodes, 2);
+
+	this->nodes.clear();
+	this->nodes.reserve(n_nodes);
+	for (std::size_t i = 0; i < n_nodes; i++)
+	{
+		Eigen::Quaterniond q(this->spice.fetch_rot_matrix(this->et0 + i * step, this->from_frame, this->to_frame));
+		//keep neighbors in the same hemisphere so the table itself is continuous (slerp would cope either way)
+		if (i > 0 && q.dot(this->nodes.back()) < 0.0)
+		{
+			q.coeffs() *= -1.0;
+		}
+		this->nodes.push_back(q);
+	}
+}
+
+double RotationCache::midpoint_error()
+{
+	double worst = 0.0;
+	for (std::size_t i = 0; i + 1 < this->nodes.size(); i++)
+	{
+		double et = this->et0 + (i + 0.5) * this->step;
+		Eigen::Quaterniond truth(this->spice.fetch_rot_matrix(et, this->from_frame, this->to_frame));
+		worst = std::max(worst, this->nodes[i].slerp(0.5, this->nodes[i + 1]).angularDistance(truth));
+	}
+	return worst;
+}
+#pragma endregion utilities
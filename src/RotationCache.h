@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+#include "SpiceHandler.h"
+
+class RotationCache
+{
+public:
+	//precomputed frame rotation (e.g. J2000 -> IAU_EARTH) over a fixed time span
+	//pxform_c is sampled once on a uniform grid and stored as unit quaternions; queries slerp between the two
+	// neighboring grid points, so they never touch SPICE and are safe to call from any number of threads
+	//the grid is checked against pxform_c at every interval midpoint (worst case for slerp) and refined by halving
+	// the spacing until the largest rotation error is within max_error
+	//note: rotations follow the same convention as SpiceHandler::fetch_rot_matrix, v_to = C * v_from
+	RotationCache(SpiceHandler& spice, std::string from_frame, std::string to_frame, double et0, double etf);
+	RotationCache(SpiceHandler& spice, std::string from_frame, std::string to_frame, double et0, double etf,
+				  double initial_step, double max_error);
+
+	//don't want copies of the (potentially large) tables floating around
+	RotationCache(const RotationCache&) = delete;
+	RotationCache& operator=(const RotationCache&) = delete;
+	RotationCache(RotationCache&&) = delete;
+	RotationCache& operator=(RotationCache&&) = delete;
+
+	//getters
+	int get_from_frame_id() const;
+	int get_to_frame_id() const;
+	double get_et0() const;
+	double get_etf() const;
+	double get_step() const; //final grid spacing after refinement
+	double get_max_error() const; //requested accuracy bound [rad]
+	double get_achieved_error() const; //largest midpoint error found during the last check [rad]
+	std::size_t get_node_count() const;
+
+	//utilities
+	bool covers(double et) const;
+	Eigen::Quaterniond quaternion(double et) const;
+	Eigen::Matrix3d rotation(double et) const;
+	void rotations(const std::vector<double>& ets, std::vector<Eigen::Matrix3d>& out) const; //batch version of rotation()
+	Eigen::Vector3d rotate(double et, const Eigen::Vector3d& v) const;
+
+	double check_accuracy(std::size_t n_samples); //max error vs pxform_c at n_samples random epochs in the span [rad]
+
+private:
+	void build(double step);
+	double midpoint_error(); //max error vs pxform_c at every interval midpoint
+
+	SpiceHandler& spice;
+	std::string from_frame; //canonical SPICE names (resolved through the frame ids once up front)
+	std::string to_frame;
+	int from_frame_id;
+	int to_frame_id;
+
+	double et0;
+	double etf;
+	double step;
+	double max_error;
+	double achieved_error;
+
+	std::vector<Eigen::Quaterniond> nodes; //rotation at et0 + i * step
+};
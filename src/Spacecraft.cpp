@@ -1,16 +1,22 @@
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <stdexcept>
 #include "Spacecraft.h"
+#include "HistoryFile.h"
+#include "HistorySink.h"
 #include <astrokit/state_converter.h>
+#include <astrokit/kepler.h>
 
 Spacecraft::Spacecraft(Integrator& integrator) : 
-	name("Default"), current_state{}, et_history(), cartesian_history(), coe_history(), integrator(integrator)
+	name("Default"), current_state{}, history(), current_coes_valid(true), 
+	tracking_ref{}, tracking_ref_valid(false), tracking_next_row(0), step_guess(0.0), front_valid(false), streamed_rows(0), integrator(integrator)
 {	
 }
 
 //best option is to provide the State struct directly in the constructor
 Spacecraft::Spacecraft(Integrator& integrator, std::string name, State state) : 
-	integrator(integrator)
+	tracking_ref{}, tracking_ref_valid(false), tracking_next_row(0), step_guess(0.0), front_valid(false), streamed_rows(0), integrator(integrator)
 {
 	set_name(name);
 	reset_state(state); //reset_state function sets the current_state and stores it as the first (and only) entry in the state_history
@@ -19,7 +25,7 @@ Spacecraft::Spacecraft(Integrator& integrator, std::string name, State state) :
 
 //there may be times it is convenient to just provide the cartesian state (& mu) and let the constructor fill in the COE information
 Spacecraft::Spacecraft(Integrator& integrator, std::string name, double et, Eigen::Vector3d pos, Eigen::Vector3d vel, double mu_cb) :
-	integrator(integrator)
+	tracking_ref{}, tracking_ref_valid(false), tracking_next_row(0), step_guess(0.0), front_valid(false), streamed_rows(0), integrator(integrator)
 {
 	set_name(name);
 	reset_state(et, pos, vel, mu_cb); //overloaded functions handle necessary computations to fill in the rest of the State
@@ -27,7 +33,7 @@ Spacecraft::Spacecraft(Integrator& integrator, std::string name, double et, Eige
 
 //there will also be times we want to initialize a spacecraft by COEs
 Spacecraft::Spacecraft(Integrator& integrator, std::string name, double et, Eigen::Vector<double, 6> coes, double mu_cb) :
-	integrator(integrator)
+	tracking_ref{}, tracking_ref_valid(false), tracking_next_row(0), step_guess(0.0), front_valid(false), streamed_rows(0), integrator(integrator)
 {
 	set_name(name);
 	reset_state(et, coes, mu_cb);
@@ -35,12 +41,23 @@ Spacecraft::Spacecraft(Integrator& integrator, std::string name, double et, Eige
 
 Spacecraft::Spacecraft(const Spacecraft& other)
 	: name(other.name),
+	ref_conic(other.ref_conic),
+	ref_period(other.ref_period),
 	current_state(other.current_state),
-	et_history(other.et_history),
-	cartesian_history(other.cartesian_history),
-	coe_history(other.coe_history),
+	history(other.history),
+	current_coes_valid(other.current_coes_valid),
 	tracking(other.tracking),
-	collected_history(other.collected_history),
+	tracking_window(other.tracking_window),
+	tracking_ref(other.tracking_ref),
+	tracking_ref_valid(other.tracking_ref_valid),
+	tracking_next_row(other.tracking_next_row),
+	step_guess(other.step_guess),
+	front_valid(other.front_valid),
+	front_et(other.front_et),
+	front_state(other.front_state),
+	front_deriv(other.front_deriv),
+	last_step(other.last_step),
+	streamed_rows(other.streamed_rows),
 	integrator(other.integrator)   // bind our reference to the same Integrator; note: the integrator handling is what requires these
 {
 }
@@ -50,12 +67,23 @@ Spacecraft& Spacecraft::operator=(const Spacecraft& other)
 	if (this != &other)
 	{
 		this->name = other.name;
+		this->ref_conic = other.ref_conic;
+		this->ref_period = other.ref_period;
 		this->current_state = other.current_state;
-		this->et_history = other.et_history;
-		this->cartesian_history = other.cartesian_history;
-		this->coe_history = other.coe_history;
+		this->history = other.history;
+		this->current_coes_valid = other.current_coes_valid;
 		this->tracking = other.tracking;
-		this->collected_history = other.collected_history;
+		this->tracking_window = other.tracking_window;
+		this->tracking_ref = other.tracking_ref;
+		this->tracking_ref_valid = other.tracking_ref_valid;
+		this->tracking_next_row = other.tracking_next_row;
+		this->step_guess = other.step_guess;
+		this->front_valid = other.front_valid;
+		this->front_et = other.front_et;
+		this->front_state = other.front_state;
+		this->front_deriv = other.front_deriv;
+		this->last_step = other.last_step;
+		this->streamed_rows = other.streamed_rows;
 	}
 	return *this;
 }
@@ -74,7 +102,25 @@ COE Spacecraft::get_ref_conic() const
 
 State Spacecraft::get_state() const
 {
-	return this->current_state;
+	State state = this->current_state;
+	if (!this->current_coes_valid)
+	{
+		Eigen::Vector<double, 6> cart;
+		cart << state.pos, state.vel;
+		Eigen::Vector<double, 6> coes = astrokit::cart_to_coe(cart, this->integrator.get_cb().get_mu());
+		state.sma = coes[0];
+		state.ecc = coes[1];
+		state.inc = coes[2];
+		state.raan = coes[3];
+		state.argp = coes[4];
+		state.ta = coes[5];
+	}
+	return state;
+}
+
+double Spacecraft::get_et() const
+{
+	return this->current_state.et;
 }
 
 TrackingState Spacecraft::get_tracking() const
@@ -82,19 +128,73 @@ TrackingState Spacecraft::get_tracking() const
 	return this->tracking;
 }
 
-const std::vector<double>& Spacecraft::get_et_history() const
+TrackingState Spacecraft::get_tracking_ref() const
+{
+	return this->tracking_ref;
+}
+
+bool Spacecraft::has_tracking_ref() const
 {
-	return this->et_history;
+	return this->tracking_ref_valid;
 }
 
-const std::vector<Eigen::Vector<double, 6>>& Spacecraft::get_cartesian_history() const
+bool Spacecraft::has_full_tracking_window() const
 {
-	return this->cartesian_history;
+	return this->tracking_window.get_span() >= this->ref_period * (1.0 - 1e-9);
 }
 
-const std::vector<Eigen::Vector<double, 6>>& Spacecraft::get_coe_history() const
+double Spacecraft::get_ref_raan_rate() const
 {
-	return this->coe_history;
+	if (!this->integrator.get_fm().get_include_j2())
+	{
+		return 0.0;
+	}
+	//note: uses the tracked means once they exist; the rate from the osculating conic is off by enough (a few
+	//      hundredths of a degree a day in LEO) to walk a tight raan box on its own
+	const Planet& cb = this->integrator.get_cb();
+	double sma = this->tracking_ref_valid ? this->tracking_ref.sma_mean : this->ref_conic.sma;
+	double inc = this->tracking_ref_valid ? this->tracking_ref.inc_mean : this->ref_conic.inc;
+	return astrokit::j2_secular_rates(sma, this->ref_conic.ecc, inc, cb.get_mu(), cb.get_eq_radius(), cb.get_j2())[0];
+}
+
+const HistoryArena& Spacecraft::get_history() const
+{
+	return this->history;
+}
+
+HistoryArena::ConstColumn Spacecraft::get_et_history() const
+{
+	return this->history.et();
+}
+
+HistoryArena::ConstBlock Spacecraft::get_cartesian_history() const
+{
+	return this->history.cartesian();
+}
+
+HistoryArena::ConstBlock Spacecraft::get_coe_history() const
+{
+	if (!this->history.has_coes())
+	{
+		throw std::runtime_error("Spacecraft " + get_name() + " is not recording an orbital element history.");
+	}
+	update_coe_history();
+	return this->history.coes();
+}
+
+std::size_t Spacecraft::get_streamed_rows() const
+{
+	return this->streamed_rows;
+}
+
+double Spacecraft::get_ref_period() const
+{
+	return this->ref_period;
+}
+
+bool Spacecraft::get_coe_history_enabled() const
+{
+	return this->history.has_coes();
 }
 #pragma endregion getters
 
@@ -109,19 +209,32 @@ void Spacecraft::set_state(State new_state)
 	//method for updating the spacecraft's state information
 	//predominantly used by the propagator to update the s/c with each step
 	this->current_state = new_state;
+	this->current_coes_valid = true;
 	add_state_to_history_vecs(new_state);
 }
 
+void Spacecraft::set_coe_history_enabled(bool enabled)
+{
+	this->history.set_with_coes(enabled);
+}
+
 void Spacecraft::set_ref_conic(COE new_conic)
 {
 	this->ref_conic = new_conic;
 	this->ref_period = 2 * astrokit::PI * sqrt(pow(new_conic.sma, 3)  / this->integrator.get_cb().get_mu());
 }
 
+void Spacecraft::set_tracking_ref(TrackingState new_ref)
+{
+	this->tracking_ref = new_ref;
+	this->tracking_ref_valid = true;
+}
+
 void Spacecraft::reset_state(State state0)
 {
 	//set the current state
 	this->current_state = state0;
+	this->current_coes_valid = true;
 
 	//and reinitialize the state history vectors
 	reset_state_history_vecs(state0);
@@ -179,6 +292,7 @@ void Spacecraft::update_current_state_coes(double mu_cb)
 	this->current_state.raan = coes[3];
 	this->current_state.argp = coes[4];
 	this->current_state.ta = coes[5];
+	this->current_coes_valid = true;
 }
 
 void Spacecraft::update_current_state_cart(double mu_cb)
@@ -192,43 +306,88 @@ void Spacecraft::update_current_state_cart(double mu_cb)
 	this->current_state.vel = cart.segment<3>(3);
 }
 
-void Spacecraft::reset_state_history_vecs(State new_state)
+void Spacecraft::update_coe_history() const
 {
-	//et history for time
-	this->et_history = { new_state.et };
+	if (!this->history.has_coes())
+	{
+		return;
+	}
 
-	//cartesian for ICRF pos, vel
+	//bulk conversion of every row since the last request
+	double mu_cb = this->integrator.get_cb().get_mu();
+	for (std::size_t i = this->history.get_coe_rows(); i < this->history.get_rows(); i++)
+	{
+		this->history.set_coes(i, astrokit::cart_to_coe(this->history.cart_at(i), mu_cb));
+	}
+}
+
+Eigen::Vector<double, 6> Spacecraft::get_history_coes(std::size_t ix) const
+{
+	if (ix < this->history.get_coe_rows())
+	{
+		return this->history.coe_at(ix);
+	}
+	return astrokit::cart_to_coe(this->history.cart_at(ix), this->integrator.get_cb().get_mu());
+}
+
+void Spacecraft::reserve_history(std::size_t n_rows)
+{
+	this->history.reserve(n_rows);
+}
+
+void Spacecraft::stream_history(HistorySink& sink, std::size_t sc_index, std::size_t keep_rows)
+{
+	//everything from streamed_rows on hasn't gone to the sink yet; the arena always still holds those rows
+	std::size_t n_rows = this->history.get_rows();
+	std::size_t first_new = this->streamed_rows - this->history.get_first_row();
+	if (first_new < n_rows)
+	{
+		update_coe_history(); //the sink gets finished rows, elements included
+		sink.write(sc_index, this->name, this->streamed_rows,
+				   this->history.block(first_new, n_rows - first_new, 0, this->history.get_cols()));
+		this->streamed_rows = this->history.get_first_row() + n_rows;
+	}
+
+	//everything is streamed now, so only the recent window needs to stay in memory
+	if (n_rows > keep_rows)
+	{
+		this->history.discard_front(n_rows - keep_rows);
+	}
+}
+
+void Spacecraft::reset_state_history_vecs(State new_state)
+{
+	//history restarts with just the new state (elements get filled lazily from the cartesian columns)
 	Eigen::Vector<double, 6> cart_state;
 	cart_state << new_state.pos, new_state.vel;
-	this->cartesian_history = { cart_state };
+	this->history.clear();
+	reset_tracking(); //the tracking window starts over with the new history (from its first row)
+	this->tracking_ref_valid = false; //and a new orbit needs a new station-keeping reference
+	this->history.append(new_state.et, cart_state);
+	this->streamed_rows = 0; //a history sink sees the restarted history from row 0 again
 
-	//coe for instaneous orbital elements
-	Eigen::Vector<double, 6> coe_state;
-	coe_state << new_state.sma, new_state.ecc, new_state.inc, new_state.raan, new_state.argp, new_state.ta;
-	this->coe_history = { coe_state };
+	//any dense-output integration front belongs to the old state
+	this->front_valid = false;
 }
 
 void Spacecraft::add_state_to_history_vecs(State new_state)
 {
-	this->et_history.push_back(new_state.et);
-
 	Eigen::Vector<double, 6> cart_state;
 	cart_state << new_state.pos, new_state.vel;
-	this->cartesian_history.push_back(cart_state);
-
-	Eigen::Vector<double, 6> coe_state;
-	coe_state << new_state.sma, new_state.ecc, new_state.inc, new_state.raan, new_state.argp, new_state.ta;
-	this->coe_history.push_back(coe_state);
+	this->history.append(new_state.et, cart_state);
+	//note: element columns catch up lazily in update_coe_history
 }
 
 void Spacecraft::apply_dv(Eigen::Vector3d dv_vec)
+{
+	apply_dv(dv_vec, true);
+}
+
+void Spacecraft::apply_dv(Eigen::Vector3d dv_vec, bool add_history_row)
 {
 	// note: applies an impulsive delta-v to the sc
 	// need to update both the velocity vector and COEs
-	//don't want to require mu as an input, so reverse engineer it before updating the velocity
-	double R = this->current_state.pos.norm();
-	double V = this->current_state.vel.norm();
-	double mu_cb = V * V / (2 / R - 1 / this->current_state.sma);
+	double mu_cb = this->integrator.get_cb().get_mu();
 
 	//now update the velocity vector
 	this->current_state.vel = this->current_state.vel + dv_vec;
@@ -236,37 +395,125 @@ void Spacecraft::apply_dv(Eigen::Vector3d dv_vec)
 	//and update the coes
 	update_current_state_coes(mu_cb);
 
+	//the integration front (dense output) no longer matches the trajectory
+	this->front_valid = false;
+
 	//now that our state is fully updated; append it as a new step in our state_history
+	if (add_history_row)
+	{
+		add_state_to_history_vecs(this->current_state);
+	}
+}
+
+void Spacecraft::repeat_history_row()
+{
+	std::size_t last = this->history.get_rows() - 1;
+	this->history.append(this->history.et_at(last), this->history.cart_at(last));
+}
+
+void Spacecraft::set_cartesian_state(double et, const Eigen::Vector<double, 6>& cart)
+{
+	//update the time & cartesian components of the current_state
+	this->current_state.et = et;
+	this->current_state.pos = cart.segment<3>(0);
+	this->current_state.vel = cart.segment<3>(3);
+	//note: the COEs are left stale on purpose; get_state & the history getters fill them in when they're needed
+	this->current_coes_valid = false;
+
+	//now add the updated state to the state_history
+	add_state_to_history_vecs(this->current_state);
+}
+
+void Spacecraft::set_state_with_coes(double et, const Eigen::Vector<double, 6>& cart, const Eigen::Vector<double, 6>& coes)
+{
+	this->current_state.et = et;
+	this->current_state.pos = cart.segment<3>(0);
+	this->current_state.vel = cart.segment<3>(3);
+	this->current_state.sma = coes[0];
+	this->current_state.ecc = coes[1];
+	this->current_state.inc = coes[2];
+	this->current_state.raan = coes[3];
+	this->current_state.argp = coes[4];
+	this->current_state.ta = coes[5];
+	this->current_coes_valid = true;
+	this->front_valid = false;
+
 	add_state_to_history_vecs(this->current_state);
+
+	//the element columns must stay a prefix; if older rows are still waiting on the lazy conversion, convert them all
+	// (this row included) instead of storing the given elements out of order
+	if (this->history.has_coes())
+	{
+		if (this->history.get_coe_rows() + 1 < this->history.get_rows())
+		{
+			update_coe_history();
+		}
+		else
+		{
+			this->history.set_coes(this->history.get_rows() - 1, coes);
+		}
+	}
 }
+
 void Spacecraft::step(double dt)
 {
 	double t = this->current_state.et;
 	Eigen::Vector<double, 6> state;
 	state << this->current_state.pos, this->current_state.vel;
 
-	Eigen::Vector<double, 6> new_state = integrator.step(t, dt, state);
+	//adaptive integrators take as many internal steps as their tolerances need to cover dt; the
+	// output still lands exactly on t + dt
+	Eigen::Vector<double, 6> new_state = integrator.is_adaptive() ? integrator.propagate(t, t + dt, state, this->step_guess)
+	                                                              : integrator.step(t, dt, state);
 
-	//update the time & cartesian components of the current_state
-	this->current_state.et += dt;
-	this->current_state.pos = new_state.segment<3>(0);
-	this->current_state.vel = new_state.segment<3>(3);
-	//and fill in the new COE information
-	update_current_state_coes(this->integrator.get_cb().get_mu()); 
+	set_cartesian_state(t + dt, new_state);
+}
 
-	//now add the updated state to the state_history
-	add_state_to_history_vecs(this->current_state);
+void Spacecraft::advance_to(double et, double integration_step)
+{
+	//(re)start the integration front from the current state if needed
+	if (!this->front_valid)
+	{
+		this->front_et = this->current_state.et;
+		this->front_state << this->current_state.pos, this->current_state.vel;
+		this->front_deriv = this->integrator.eoms(this->front_et, this->front_state);
+		this->last_step = astrokit::DenseStep<Eigen::Vector<double, 6>>{ this->front_et, 0.0, this->front_state, 
+			this->front_state * 0.0, this->front_state * 0.0, this->front_state * 0.0, this->front_state * 0.0, this->front_state * 0.0 };
+		this->front_valid = true;
+	}
+
+	//integrate ahead until the latest step covers et (forward propagation only, like the rest of propagate)
+	while (this->front_et < et)
+	{
+		double dt = integration_step;
+		if (this->integrator.is_adaptive())
+		{
+			dt = (this->step_guess > 0.0) ? this->step_guess : et - this->front_et;
+		}
+		double dt_next;
+		this->front_state = this->integrator.dense_step(this->front_et, dt, this->front_state, this->front_deriv, this->last_step, dt_next);
+		this->front_et += dt;
+		this->step_guess = dt_next;
+	}
+
+	//sample the continuous extension (exact front state if we landed right on it)
+	Eigen::Vector<double, 6> state = (et == this->front_et) ? this->front_state : this->last_step.evaluate(et);
+	set_cartesian_state(et, state);
 }
 
-std::size_t Spacecraft::get_et_index(double target_et)
+const astrokit::DenseStep<Eigen::Vector<double, 6>>& Spacecraft::get_last_step() const
+{
+	return this->last_step;
+}
+
+std::size_t Spacecraft::get_et_index(double target_et) const
 {
 	//the main use of this function is to find the vector indeces for orbital element averages.
-	//  to that end, we don't need an exact match. just the closest points in our dataset. if the
-	//  exact target_et doesn't appear in the et_history, this function will loop until 
+	//  to that end, we don't need an exact match. just the closest row at or before target_et (see HistoryArena::find_row)
 	
-	//before we loop, make sure the target_et is in the et_history range (ASSUMES CONSISTENT FORWARD/BACKPROP DIRECTION FOR HISTORY)
-	double et0 = this->et_history[0];
-	double etf = this->et_history[this->et_history.size() - 1];
+	//before we look it up, make sure the target_et is in the et_history range (ASSUMES CONSISTENT FORWARD/BACKPROP DIRECTION FOR HISTORY)
+	double et0 = this->history.et_at(0);
+	double etf = this->history.et_at(this->history.get_rows() - 1);
 
 	//check that they haven't asked for a future time step in the propagation (either forward in time for forward prop or backward for backprop)
 	if ((etf > et0 && target_et > etf) || (et0 > etf && target_et < etf))
@@ -274,136 +521,194 @@ std::size_t Spacecraft::get_et_index(double target_et)
 		throw std::runtime_error("Spacecraft " + get_name() + " requested state beyond propagation bounds.");
 	}
 
-	//on the other hand, if they requested a target_et that is in the right direction but extends beyond the state history
-	if ((etf > et0 && target_et < et0) || (et0 > etf && target_et > et0))
+	//note: a target_et that's before the start of the history comes back as index 0 (just use the full history in this case)
+	return this->history.find_row(target_et);
+}
+
+std::pair<std::size_t, std::size_t> Spacecraft::get_et_indices(double et0, double etf) const
+{
+	//first & last rows covering [et0, etf]; same rules as get_et_index for each end
+	return { get_et_index(et0), get_et_index(etf) };
+}
+
+void Spacecraft::update_tracking(Spacecraft& neighbor1, Spacecraft& neighbor2)
+{
+	//mean elements & neighbor phasing over the last orbit period (using the period of the reference conic)
+	//note: rows get folded into the rolling window once each, in order; anything older than the period drops out the
+	//      back. so each call costs O(new rows) instead of re-reading the whole period
+	std::size_t row0 = start_tracking_update();
+	std::size_t first_row = this->history.get_first_row();
+	std::size_t end_row = first_row + this->history.get_rows();
+
+	std::size_t n1_first = neighbor1.history.get_first_row();
+	std::size_t n2_first = neighbor2.history.get_first_row();
+	if (n1_first > row0 || n2_first > row0 ||
+		n1_first + neighbor1.history.get_rows() < end_row || n2_first + neighbor2.history.get_rows() < end_row)
 	{
-		return 0; //just return index 0 (just use the full history in this case)
+		throw std::runtime_error("Spacecraft " + get_name() + " update_tracking neighbors aren't on the same history rows.");
 	}
 
-	//if we make it here, the target_et should fall somewhere in our propagation history
-	//loop from the end to the beginning of et_history and find the closest match
-	int current_sign = astrokit::sign(target_et - this->current_state.et);
-	int previous_sign;
-	for (std::size_t i = this->et_history.size()-1; i >= 0; i--)
+	for (std::size_t row = row0; row < end_row; row++)
 	{
-		//if not, check for if we've gone from undershooting to overshooting our target_et
-		previous_sign = current_sign;
-		current_sign = astrokit::sign(target_et - this->et_history[i]);
-		//note: the astrokit::sign function returns +1, 0, or -1 if the input is >0, =0, or <0 respectively
-		if (current_sign != previous_sign)
-		{
-			return i;
-		}
+		//note: don't want to worry about angle wrapping issues; just use the position vectors and find the angle between
+		Eigen::Vector3d my_pos = this->history.cart_at(row - first_row).head<3>();
+		Eigen::Vector3d n1_pos = neighbor1.history.cart_at(row - n1_first).head<3>();
+		Eigen::Vector3d n2_pos = neighbor2.history.cart_at(row - n2_first).head<3>();
+		add_tracking_sample(row, astrokit::angle_between_vecs(my_pos, n1_pos), astrokit::angle_between_vecs(my_pos, n2_pos));
 	}
-	//should never make it here, but just in case (REMOVE BEFORE FLIGHT)
-	throw std::runtime_error("Error in Spacecraft " + get_name() + " get_et_index function for time " + std::to_string(target_et) + ".");
+	finish_tracking_update();
 }
 
-void Spacecraft::update_tracking(Spacecraft& neighbor1, Spacecraft& neighbor2)
+void Spacecraft::update_tracking(std::size_t row0, const double* neighbor1_angles, const double* neighbor2_angles)
 {
-	//first need to determine the mean elements over the last orbit period
-	double etf = get_state().et;
-	double et0 = etf - this->ref_period;
+	std::size_t start_row = start_tracking_update();
+	if (start_row < row0)
+	{
+		throw std::runtime_error("Spacecraft " + get_name() + " update_tracking is missing neighbor angles from row " + std::to_string(start_row) + ".");
+	}
+	std::size_t end_row = this->history.get_first_row() + this->history.get_rows();
+	for (std::size_t row = start_row; row < end_row; row++)
+	{
+		add_tracking_sample(row, neighbor1_angles[row - row0], neighbor2_angles[row - row0]);
+	}
+	finish_tracking_update();
+}
 
-	std::size_t start_ix = get_et_index(et0);
-	std::size_t stop_ix = get_et_index(etf);
+std::size_t Spacecraft::get_tracking_next_row() const
+{
+	std::size_t first_row = this->history.get_first_row();
+	if (this->tracking_next_row > first_row + this->history.get_rows())
+	{
+		return first_row; //the history was restarted out from under us
+	}
+	return std::max(this->tracking_next_row, first_row);
+	//note: rows streamed out & discarded before tracking saw them are skipped
+}
 
-	//get the data we need for the average elements
-	//note: computing the mean over the last period's worth of data (using the period of the reference conic)
-	Eigen::MatrixXd dat = build_partial_eigen_history(start_ix, stop_ix);
-	
-	//now fill in the tracking data
-	//dat columns:
-	//et, rx, ry, rz, vx, vy, vz, sma, ecc, inc, raan, argp, ta
-	// 0,  1,  2,  3,  4,  5,  6,   7,   8,   9,   10,   11, 12
-	this->tracking.et = etf;
-	this->tracking.sma_mean = dat.col(7).mean();
-	this->tracking.inc_mean = dat.col(9).mean();
-	this->tracking.raan_mean = dat.col(10).mean();
-
-	//now check phasing w/neighbors
-	//note: don't want to worry about angle wrapping issues; just use the position vectors and find the angle between
-	Eigen::MatrixXd n1_dat = neighbor1.build_partial_eigen_history(start_ix, stop_ix);
-	Eigen::MatrixXd n2_dat = neighbor2.build_partial_eigen_history(start_ix, stop_ix);
-	double n1_angle_sum = 0.0;
-	double n2_angle_sum = 0.0;
-	for (std::size_t i = 0; i < dat.size(); i++)
+double Spacecraft::get_raan_error() const
+{
+	//the reference plane precesses with J2 like the real one does; only the difference from that drift counts
+	const TrackingState& ref = this->tracking_ref;
+	return astrokit::wrap_pi(this->tracking.raan_mean - (ref.raan_mean + get_ref_raan_rate() * (this->tracking.et - ref.et)));
+}
+
+void Spacecraft::reset_tracking()
+{
+	this->tracking_window.clear();
+	this->tracking_next_row = this->history.get_first_row() + this->history.get_rows();
+}
+
+std::size_t Spacecraft::start_tracking_update()
+{
+	if (this->tracking_next_row > this->history.get_first_row() + this->history.get_rows())
 	{
-		Eigen::Vector3d my_pos = dat.row(i).segment<3>(1); //segment of 3 columns starting at index 1 in row i -> position components at the correct time step
-		double n1_angle = astrokit::angle_between_vecs(my_pos, n1_dat.row(i).segment<3>(1));
-		double n2_angle = astrokit::angle_between_vecs(my_pos, n2_dat.row(i).segment<3>(1));
+		reset_tracking();
+	}
+	this->tracking_next_row = get_tracking_next_row();
+	return this->tracking_next_row;
+}
+
+void Spacecraft::add_tracking_sample(std::size_t row, double neighbor1_angle, double neighbor2_angle)
+{
+	std::size_t ix = row - this->history.get_first_row();
+	this->tracking_next_row = row + 1;
+	if (this->tracking_window.get_size() > 0 && this->history.et_at(ix) == this->tracking_window.get_last_et())
+	{
+		return; //zero-length row (a burn elsewhere in the constellation); the same epoch would count twice in the means
+	}
+	Eigen::Vector<double, 6> coes = get_history_coes(ix);
+
+	TrackingWindow::Sample sample;
+	sample.et = this->history.et_at(ix);
+	sample.sma = coes[0];
+	sample.inc = coes[2];
+	sample.raan = coes[3];
+	sample.neighbor1_angle = neighbor1_angle;
+	sample.neighbor2_angle = neighbor2_angle;
+	this->tracking_window.push(sample);
+}
 
-		n1_angle_sum += n1_angle;
-		n2_angle_sum += n2_angle;
+void Spacecraft::finish_tracking_update()
+{
+	double etf = get_et();
+	this->tracking_window.drop_before(etf - this->ref_period);
+	this->tracking = this->tracking_window.get_means();
+	this->tracking.et = etf;
+
+	//the first full period of tracking becomes the station-keeping reference
+	if (!this->tracking_ref_valid && has_full_tracking_window())
+	{
+		this->tracking_ref = this->tracking;
+		this->tracking_ref_valid = true;
 	}
-	this->tracking.neighbor1_rel_angle = n1_angle_sum / dat.size();
-	this->tracking.neighbor2_rel_angle = n2_angle_sum / dat.size();
 }
 
-bool Spacecraft::check_in_bounds(const BoundingBox& bounds)
+bool Spacecraft::check_in_bounds(const BoundingBox& bounds) const
 {
-	//working on this logic now
 	//using Galileo as a reference point: GALILEO CONSTELLATION: EVALUATION OF STATION KEEPING STRATEGIES by Navarro-Reyes, et. al.
-	return true;
+	return !check_bounds(bounds).any();
+}
+
+BoundsCheck Spacecraft::check_bounds(const BoundingBox& bounds) const
+{
+	return check_bounds(bounds, 0.0);
+}
+
+BoundsCheck Spacecraft::check_bounds(const BoundingBox& bounds, double raan_offset) const
+{
+	BoundsCheck result;
+	if (!this->tracking_ref_valid || !has_full_tracking_window())
+	{
+		return result;
+	}
+	const TrackingState& ref = this->tracking_ref;
+	const TrackingState& now = this->tracking;
+
+	result.sma = std::abs(now.sma_mean - ref.sma_mean) > bounds.dsma;
+	result.inc = std::abs(now.inc_mean - ref.inc_mean) > bounds.dinc;
+	result.raan = std::abs(get_raan_error() - raan_offset) > bounds.draan;
+	result.arglat = std::abs(now.neighbor1_rel_angle - ref.neighbor1_rel_angle) > bounds.darglat;
+	return result;
 }
 #pragma endregion utilities
 
 #pragma region data handling
 void Spacecraft::history_row_count_validation()
 {
-	//want to throw an error if the state histories somehow ended up as different sizes
-	if (this->et_history.size() != this->cartesian_history.size() || this->et_history.size() != this->coe_history.size())
+	//want to throw an error if the element columns somehow got ahead of the state history
+	if (this->history.get_coe_rows() > this->history.get_rows())
 	{
 		throw std::runtime_error("History length mismatch in Spacecraft " + get_name() + ".");
 	} //shouldn't be necessary but a good sanity check during development
 }
 
-Eigen::MatrixXd Spacecraft::build_partial_eigen_history(std::size_t ix0, std::size_t ixf)
+HistoryArena::ConstBlock Spacecraft::build_partial_eigen_history(std::size_t ix0, std::size_t ixf)
 {
-	const int n_rows = ixf - ix0;
-	Eigen::MatrixXd out(ixf - ix0, 13);
-
-	for (std::size_t i = ix0; i <= ixf; i++)
-	{
-		out(i, 0) = this->et_history[i];
-		out.block<1, 6>(i, 1) = this->cartesian_history[i].transpose();
-		out.block<1, 6>(i, 7) = this->coe_history[i].transpose();
-	}
-	return out;
+	//just a view into the arena; only the element columns may need filling in first
+	update_coe_history();
+	return this->history.block(ix0, ixf - ix0 + 1, 0, this->history.get_cols());
 }
 
-void Spacecraft::build_eigen_state_history()
+void Spacecraft::write_history_to_csv(std::string filename)
 {
 	history_row_count_validation(); //sanity check
 
-	//before we store the data, need to resize the collected_history matrix
-	std::size_t n_states = get_et_history().size();
-	this->collected_history.resize(n_states, 13);
+	//bring the lazily-computed elements up to date in one pass
+	update_coe_history();
 
-	//now store the vector data into the Eigen matrix
-	for (std::size_t i = 0; i < n_states; i++)
-	{
-		this->collected_history(i, 0) = this->et_history[i];
-		this->collected_history.block<1, 6>(i, 1) = this->cartesian_history[i].transpose();
-		this->collected_history.block<1, 6>(i, 7) = this->coe_history[i].transpose();
-	}
+	//and write the data straight from the arena (no intermediate matrix)
+	//note: without an element history we only carry et + cartesian
+	HistoryFile::write_csv(filename, this->history);
 }
 
-void Spacecraft::write_history_to_csv(std::string filename)
+void Spacecraft::write_history_to_binary(std::string filename)
 {
 	history_row_count_validation(); //sanity check
 
-	//make sure the collected_history is up-to-date
-	build_eigen_state_history();
-	
-	//now create a csv file to save to
-	std::ofstream f(filename);
-
-	//write the header row
-	f << "et,rx,ry,rz,vx,vy,vz,sma,ecc,inc,raan,argp,ta\n";
+	//bring the lazily-computed elements up to date in one pass
+	update_coe_history();
 
-	//and write the data
-	Eigen::IOFormat csv(Eigen::FullPrecision, Eigen::DontAlignCols, ",", "\n");
-	f << this->collected_history.format(csv);
+	//note: states are propagated in the J2000 inertial frame
+	HistoryFile::write(filename, this->name, "J2000", this->history);
 }
 #pragma endregion data handling
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include "structure_definitions.h"
 #include "Integrator.h"
 #include "Planet.h"
+#include "HistoryArena.h"
+#include "TrackingWindow.h"
 
 
 class Spacecraft
@@ -22,17 +24,30 @@ public:
 	//getters
 	std::string get_name() const;
 	COE get_ref_conic() const;
-	State get_state() const;
+	State get_state() const; //note: the COE half is computed on request if the hot path skipped it
+	double get_et() const;
 	TrackingState get_tracking() const;
-	const std::vector<double>& get_et_history() const;
-	const std::vector<Eigen::Vector<double, 6>>& get_cartesian_history() const; //ICRF
-	const std::vector<Eigen::Vector<double, 6>>& get_coe_history() const; //instantaneous elements
+	TrackingState get_tracking_ref() const; //tracking means from the first full reference period; what check_bounds measures against
+	bool has_tracking_ref() const;
+	bool has_full_tracking_window() const; //whether the current tracking means cover a whole reference period
+	double get_ref_raan_rate() const; //[rad/s]; J2 secular node drift of the reference conic (0 when the force model has no J2)
+	const HistoryArena& get_history() const; //full columnar history (et, cartesian, coes); elements may lag, see update_coe_history
+	HistoryArena::ConstColumn get_et_history() const;
+	HistoryArena::ConstBlock get_cartesian_history() const; //ICRF; n x 6
+	HistoryArena::ConstBlock get_coe_history() const; //instantaneous elements; n x 6, converted in bulk on request
+	//note: the history getters are zero-copy views into the arena; they're invalidated when the history grows
+	bool get_coe_history_enabled() const;
+	std::size_t get_streamed_rows() const; //rows handed to a history sink so far (counted from the start of the history)
+	double get_ref_period() const;
 
 	//setters
 	void set_name(std::string new_name);
 	void set_state(State new_state); //sets the current_state and also updates the state_history vector
 
+	void set_coe_history_enabled(bool enabled); //false skips element history entirely (exports become et + cartesian only)
+
 	void set_ref_conic(COE new_conic); //only to be used if the spacecraft is reset (may be reset to new orbit)
+	void set_tracking_ref(TrackingState new_ref); //overrides the captured station-keeping reference (e.g. one shared by a whole shell)
 	void reset_state(State state0); //resets state_history to only the new state0 (and sets current_state accordingly)
 	void reset_state(double et, Eigen::Vector3d pos, Eigen::Vector3d vel, double mu_cb); //alternative reset function for convenience
 	void reset_state(double et, Eigen::Vector<double, 6> coes, double mu_cb);
@@ -40,26 +55,62 @@ public:
 	//utilities
 	void update_current_state_coes(double mu_cb);
 	void update_current_state_cart(double mu_cb);
+	void update_coe_history() const; //converts any cartesian history rows that don't have elements yet
+	void reserve_history(std::size_t n_rows); //size the history arena up front so propagation never reallocates
+	void stream_history(HistorySink& sink, std::size_t sc_index, std::size_t keep_rows);
+	//note: writes every row the sink hasn't seen yet, then drops all but the newest keep_rows rows from the arena.
+	//      history indices (get_et_index etc.) are relative to the rows still in memory; see HistoryArena::get_first_row
+	Eigen::Vector<double, 6> get_history_coes(std::size_t ix) const; //elements for one history row (cached or computed)
 	void reset_state_history_vecs(State new_state);
 	void add_state_to_history_vecs(State new_state);
+	void set_cartesian_state(double et, const Eigen::Vector<double, 6>& cart); //for states propagated outside the Spacecraft (e.g. BatchPropagator)
+	void set_state_with_coes(double et, const Eigen::Vector<double, 6>& cart, const Eigen::Vector<double, 6>& coes);
+	//note: for analytic propagation where the elements come first; the history keeps these elements as-is instead of converting the cartesian state
 	//double elevation_to_ground_stations(Planet& planet); //inputs will be provided by constellation class
 	void apply_dv(Eigen::Vector3d dv_vec);
+	void apply_dv(Eigen::Vector3d dv_vec, bool add_history_row);
+	//note: the extra history row is a zero-length step (same et as the row before) holding the post-burn state, so
+	//      anything interpolating the history sees the velocity jump at the row instead of smeared across the next step
+	void repeat_history_row(); //appends the newest history row again as a zero-length row (keeps lockstep histories aligned around another spacecraft's burn)
 	
 	void step(double dt);
-
-	std::size_t get_et_index(double et); //gets the location index of the closest match to a given et in the et_history vector
+	void advance_to(double et, double integration_step);
+	//note: dense-output stepping; integrates ahead in steps of integration_step (or whatever the adaptive controller picks)
+	//      and interpolates the state at et from the step that covers it, so the output cadence is independent of the step
+	const astrokit::DenseStep<Eigen::Vector<double, 6>>& get_last_step() const; //continuous extension of the latest integration step
+
+	std::size_t get_et_index(double et) const; //gets the location index of the closest match to a given et in the et_history vector
+	std::pair<std::size_t, std::size_t> get_et_indices(double et0, double etf) const; //index range covering [et0, etf] (e.g. an averaging window)
+	//note: both are O(1) for fixed-step histories (binary search over the step segments otherwise); see HistoryArena::find_row
 	void update_tracking(Spacecraft& neighbor1, Spacecraft& neighbor2); //fills in the tracking state information
 	//note: only keeping current information for this atm, not storing the full history (by design)
-	bool check_in_bounds(const BoundingBox& bounds); //returns true/false whether or not the spacecraft is currently within the bounds
-	//note: returns an Eigen vector instead of a single bool so that we can know which check(s) failed
+	//note: the means are kept incrementally; each call only folds in the history rows added since the last one, so
+	//      calling it every step costs O(1). the neighbors need to share our output grid (lockstep) & stay the same
+	//      between calls (reset_tracking starts over, e.g. after re-pairing)
+	void update_tracking(std::size_t row0, const double* neighbor1_angles, const double* neighbor2_angles);
+	//note: same, with the neighbor angles worked out by the caller (see Constellation::update_tracking); the arrays hold
+	//      overall history rows row0 through the last row, and row0 can't be past get_tracking_next_row()
+	std::size_t get_tracking_next_row() const; //first overall history row the next update_tracking call folds in
+	void reset_tracking(); //empties the tracking window; it refills from the next history row (e.g. after a burn)
+	bool check_in_bounds(const BoundingBox& bounds) const; //returns true/false whether or not the spacecraft is currently within the bounds
+	BoundsCheck check_bounds(const BoundingBox& bounds) const; //same check, but says which element(s) failed
+	BoundsCheck check_bounds(const BoundingBox& bounds, double raan_offset) const; //raan_offset is taken off get_raan_error first (e.g. a shell's common drift)
+	//note: the tracking means are compared with get_tracking_ref (captured once the first full period is tracked) rather
+	//      than the osculating reference conic, so the J2 short-period bias in the means doesn't count against the box.
+	//      nothing fails until the reference exists & the window covers a full period
+	double get_raan_error() const; //[rad]; mean raan minus the reference raan carried forward at get_ref_raan_rate, in [-pi, pi)
 
 	//data handling
 	void history_row_count_validation();
-	Eigen::MatrixXd build_partial_eigen_history(std::size_t ix0, std::size_t ixf);
-	void build_eigen_state_history();
+	HistoryArena::ConstBlock build_partial_eigen_history(std::size_t ix0, std::size_t ixf); //rows ix0 through ixf (inclusive); zero-copy
 	void write_history_to_csv(std::string filename);
+	void write_history_to_binary(std::string filename); //columnar binary format; see HistoryFile.h
 
 private:
+	//update_tracking pieces
+	std::size_t start_tracking_update(); //returns the first row to fold in
+	void add_tracking_sample(std::size_t row, double neighbor1_angle, double neighbor2_angle);
+	void finish_tracking_update(); //trims the window to the last reference period & refreshes tracking
 
 	std::string name;
 
@@ -68,17 +119,29 @@ private:
 
 	//note: for now, leaving mass out of this simulation as a first-pass, quick software example
 	State current_state;
-	//note: using std::vector instead of Eigen matrices here since it's more efficient for memory reallocation as the states grow.
-	//		will convert the states to Eigen matrices later as needed for efficient computations.
-	std::vector<double> et_history;
-	std::vector<Eigen::Vector<double, 6>> cartesian_history; //ICRF
-	std::vector<Eigen::Vector<double, 6>> coe_history; //instantaneous orbital elements
+	//et, ICRF cartesian & instantaneous orbital element histories, stored column by column in one arena
+	//note: only the cartesian state is stored while propagating; cart_to_coe costs about as much as the force model,
+	//      so the element columns are filled lazily (in bulk) the first time someone asks for them. they always cover a
+	//      prefix of the rows. mutable so const readers can fill them; don't read the same spacecraft from several threads at once.
+	mutable HistoryArena history;
+	bool current_coes_valid; //whether current_state's COEs match its cartesian state
 
 	TrackingState tracking; //contains bounding box information for the current time
+	TrackingWindow tracking_window; //samples & running sums behind tracking, covering the last reference period
+	TrackingState tracking_ref; //station-keeping reference (see get_tracking_ref)
+	bool tracking_ref_valid;
+	std::size_t tracking_next_row; //overall history row the next update_tracking call starts from
+
+	double step_guess; //predicted integration step carried between calls to step() when the integrator is adaptive
+
+	//integration front for dense output; runs ahead of current_state, which gets interpolated from last_step
+	bool front_valid; //cleared whenever the state is changed outside the integrator (reset, impulsive dv)
+	double front_et;
+	Eigen::Vector<double, 6> front_state;
+	Eigen::Vector<double, 6> front_deriv;
+	astrokit::DenseStep<Eigen::Vector<double, 6>> last_step;
 
-	Eigen::MatrixXd collected_history;
-	//note: will hold the state history in the et_history, cartesian_history, & coe_history vectors;
-	//		this Eigen matrix will be built as needed for convenient vector math & data output
+	std::size_t streamed_rows; //overall history rows already written to a history sink
 
 	Integrator& integrator;
 };
@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include "SpiceHandler.h"
 
 
@@ -55,41 +56,51 @@ void SpiceHandler::set_pck_path(std::string new_pck_path)
 #pragma region utilities
 void SpiceHandler::load_kernels() const
 {
+	std::lock_guard<std::recursive_mutex> lock(cspice_mutex());
 	furnsh_c(this->de_path.c_str());
 	furnsh_c(this->naif_path.c_str());
 	furnsh_c(this->pck_path.c_str());
+	bump_ephemeris_generation();
 }
 
 void SpiceHandler::reload_kernels() const
 {
+	//hold the lock across the clear & reload so nobody queries an empty kernel pool in between
+	std::lock_guard<std::recursive_mutex> lock(cspice_mutex());
 	kclear_c();
 	load_kernels();
 }
 
-Eigen::Vector3d SpiceHandler::fetch_pos(double et, int target_spkid, int observer_spkid, std::string frame_name)
+Eigen::Vector3d SpiceHandler::fetch_pos(double et, int target_spkid, int observer_spkid, const std::string& frame_name) const
 {
 	std::array<Eigen::Vector3d, 2> state = fetch_state(et, target_spkid, observer_spkid, frame_name);
 	return state[0];
 }
 
-std::array<Eigen::Vector3d, 2> SpiceHandler::fetch_state(double et, int target_spkid, int observer_spkid, std::string frame_name)
+std::array<Eigen::Vector3d, 2> SpiceHandler::fetch_state(double et, int target_spkid, int observer_spkid, const std::string& frame_name) const
 {
 	SpiceDouble spice_state[6];
 	SpiceDouble lt;
-	spkez_c(target_spkid, et, frame_name.c_str(), "None", observer_spkid, spice_state, &lt);
+	{
+		std::lock_guard<std::recursive_mutex> lock(cspice_mutex());
+		spkez_c(target_spkid, et, frame_name.c_str(), "None", observer_spkid, spice_state, &lt);
+	}
 	
 	Eigen::Vector3d pos{ spice_state[0], spice_state[1], spice_state[2] };
 	Eigen::Vector3d vel{ spice_state[3], spice_state[4], spice_state[5] };
 
 	return std::array<Eigen::Vector3d, 2>{pos, vel};
 }
-Eigen::Matrix3d SpiceHandler::fetch_rot_matrix(double et, std::string from_frame, std::string to_frame)
+Eigen::Matrix3d SpiceHandler::fetch_rot_matrix(double et, const std::string& from_frame, const std::string& to_frame) const
 {
 	//pxform requires a SpiceDouble object for the rotation matrix, C
 	//create one to retrieve the rot matrix information, then transfer the data
 	// to an Eigen 3d Matrix for output
 	SpiceDouble spice_C[3][3];
-	pxform_c(from_frame.c_str(), to_frame.c_str(), et, spice_C);
+	{
+		std::lock_guard<std::recursive_mutex> lock(cspice_mutex());
+		pxform_c(from_frame.c_str(), to_frame.c_str(), et, spice_C);
+	}
 
 	Eigen::Matrix3d C; //want to use Eigen vectors & matrices in the rest of the script
 	for (int i = 0; i < 3; i++)
@@ -101,12 +112,67 @@ Eigen::Matrix3d SpiceHandler::fetch_rot_matrix(double et, std::string from_frame
 	}
 	return C;
 }
-double SpiceHandler::str_date_to_et(std::string date_string)
+
+int SpiceHandler::frame_id(const std::string& frame_name) const
+{
+	SpiceInt id;
+	{
+		std::lock_guard<std::recursive_mutex> lock(cspice_mutex());
+		namfrm_c(frame_name.c_str(), &id);
+	}
+	if (id == 0)
+	{
+		throw std::runtime_error("SPICE doesn't recognize the frame " + frame_name + "; check the loaded kernels.");
+	}
+	return id;
+}
+
+std::string SpiceHandler::frame_name(int frame_id) const
+{
+	SpiceChar name[33]; //SPICE frame names are at most 32 characters
+	{
+		std::lock_guard<std::recursive_mutex> lock(cspice_mutex());
+		frmnam_c(frame_id, sizeof(name), name);
+	}
+	if (name[0] == '\0')
+	{
+		throw std::runtime_error("SPICE has no frame with id " + std::to_string(frame_id) + ".");
+	}
+	return std::string(name);
+}
+
+
+double SpiceHandler::str_date_to_et(std::string date_string) const
 {
 	double et;
-	str2et_c(date_string.c_str(), &et);
+	{
+		std::lock_guard<std::recursive_mutex> lock(cspice_mutex());
+		str2et_c(date_string.c_str(), &et);
+	}
 
 	return et;
 }
+
+std::uint64_t SpiceHandler::ephemeris_generation()
+{
+	return ephemeris_generation_counter().load(std::memory_order_acquire);
+}
+
+void SpiceHandler::bump_ephemeris_generation()
+{
+	ephemeris_generation_counter().fetch_add(1, std::memory_order_acq_rel);
+}
+
+std::atomic<std::uint64_t>& SpiceHandler::ephemeris_generation_counter()
+{
+	static std::atomic<std::uint64_t> generation{ 0 };
+	return generation;
+}
+
+std::recursive_mutex& SpiceHandler::cspice_mutex()
+{
+	static std::recursive_mutex mtx;
+	return mtx;
+}
 #pragma endregion utilities
 
@@ -1,6 +1,10 @@
 
 #pragma once
 #include <string>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <cspice/SpiceUsr.h>
 #include <Eigen/Dense>
 
@@ -8,6 +12,10 @@
 class SpiceHandler
 {
 public: 
+	//CSPICE keeps its kernel pool & error state in process-wide globals and isn't thread-safe, so every call into it goes
+	// through one process-wide lock (shared by all SpiceHandler instances). that makes any of these methods safe to call
+	// from worker threads, but the calls are serialized; hot paths in parallel code should read from the precomputed,
+	// immutable tables instead (RotationCache & EphemerisCache, e.g. through Planet::cache_rotations/cache_ephemeris)
 	SpiceHandler();
 	SpiceHandler(std::string de_path, std::string naif_path, std::string pck_path);
 
@@ -30,15 +38,25 @@ public:
 	//utilities
 	void load_kernels() const;
 	void reload_kernels() const;
-	Eigen::Vector3d fetch_pos(double et, int target_spkid, int observer_spkid, std::string frame_name); 
+	Eigen::Vector3d fetch_pos(double et, int target_spkid, int observer_spkid, const std::string& frame_name) const; 
 	//              ^ retrieve cartesian position from spice data
-	std::array<Eigen::Vector3d, 2> fetch_state(double et, int target_spkid, int observer_spkid, std::string frame_name); 
+	std::array<Eigen::Vector3d, 2> fetch_state(double et, int target_spkid, int observer_spkid, const std::string& frame_name) const; 
 	//                             ^ retrieve full carteisan state from spice data
-	Eigen::Matrix3d fetch_rot_matrix(double et, std::string from_frame, std::string to_frame);
-	double str_date_to_et(std::string date_string);
+	Eigen::Matrix3d fetch_rot_matrix(double et, const std::string& from_frame, const std::string& to_frame) const;
+	int frame_id(const std::string& frame_name) const; //SPICE frame id; throws if the frame isn't known to the loaded kernels
+	std::string frame_name(int frame_id) const; //canonical SPICE name for a frame id
+	double str_date_to_et(std::string date_string) const;
+
+	//process-wide count of changes to where body positions come from: bumped whenever the kernel pool is (re)loaded or an
+	// EphemerisCache is built, so anything memoizing positions can key on it & never hand back a stale lookup
+	static std::uint64_t ephemeris_generation();
+	static void bump_ephemeris_generation();
 
 
 private:
+	static std::atomic<std::uint64_t>& ephemeris_generation_counter();
+	static std::recursive_mutex& cspice_mutex(); //recursive so reload_kernels can hold it across kclear_c + load_kernels
+
 	std::string de_path; //path to de4XX.bsp file (defaults to de440s.bsp)
 	std::string naif_path; //path to naif0012.tls file
 	std::string pck_path; //path to pck00011.tpc file
@@ -0,0 +1,52 @@
+#include <array>
+#include <cstdint>
+#include "ThirdBodyTerm.h"
+#include "Planet.h"
+
+namespace
+{
+	struct MemoSlot
+	{
+		const Planet* cb = nullptr;
+		std::uint64_t generation = 0; //SpiceHandler::ephemeris_generation when the position was looked up
+		int spkid = 0;
+		double et = 0.0;
+		Eigen::Vector3d pos;
+	};
+
+	//enough for every distinct stage epoch of an RKF78 step for a couple of bodies; older entries are overwritten in turn
+	constexpr std::size_t MEMO_SLOTS = 32;
+}
+
+ThirdBodyTerm::ThirdBodyTerm(const Planet& cb, const std::vector<PerturbingBody>& bodies) : cb(cb), bodies(bodies)
+{
+}
+
+Eigen::Vector3d ThirdBodyTerm::body_position(int spkid, double et) const
+{
+	thread_local std::array<MemoSlot, MEMO_SLOTS> memo;
+	thread_local std::size_t next_slot = 0;
+	//a kernel reload or a new ephemeris cache since an entry was stored makes it stale; no need to clear anything, the
+	// old entries just stop matching
+	const std::uint64_t generation = SpiceHandler::ephemeris_generation();
+
+	//search backwards from the newest entry; in lockstep stepping the hit is almost always a few slots back
+	for (std::size_t i = 1; i <= MEMO_SLOTS; i++)
+	{
+		const MemoSlot& slot = memo[(next_slot + MEMO_SLOTS - i) % MEMO_SLOTS];
+		if (slot.cb == &this->cb && slot.generation == generation && slot.spkid == spkid && slot.et == et)
+		{
+			return slot.pos;
+		}
+	}
+
+	MemoSlot& slot = memo[next_slot];
+	slot.cb = &this->cb;
+	slot.generation = generation;
+	slot.spkid = spkid;
+	slot.et = et;
+	slot.pos = this->cb.body_position(spkid, et);
+	next_slot = (next_slot + 1) % MEMO_SLOTS;
+
+	return slot.pos;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <Eigen/Dense>
+#include <astrokit/force_models.h>
+#include "structure_definitions.h"
+
+class Planet;
+
+class ThirdBodyTerm
+{
+public:
+	//point-mass third-body perturbations (Sun, Moon, ...) as a FusedGravity term (see astrokit/force_models.h)
+	//body positions come from Planet::body_position, i.e. the planet's ephemeris cache for the epochs it covers. every
+	// spacecraft in a lockstep propagation hits the same stage epochs, so positions are also memoized per thread by
+	// epoch: a worker looks each body up once per stage epoch and every other spacecraft it steps reuses the result
+	//note: the memo returns exactly what a fresh lookup would, so results don't depend on how spacecraft are split
+	//      across threads; entries are keyed on SpiceHandler::ephemeris_generation too, so reloading the kernels or
+	//      (re)building the planet's ephemeris cache between propagations can't leave stale positions behind
+	static constexpr bool needs_r5 = false;
+
+	ThirdBodyTerm(const Planet& cb, const std::vector<PerturbingBody>& bodies);
+
+	template <typename Geometry, typename Accel>
+	void add_accel(const Geometry& g, Accel& a) const
+	{
+		for (const PerturbingBody& body : this->bodies)
+		{
+			a += astrokit::accel_third_body(g.r, body_position(body.spkid, g.t), body.mu);
+		}
+	}
+
+	Eigen::Vector3d body_position(int spkid, double et) const; //memoized Planet::body_position
+
+private:
+	const Planet& cb;
+	const std::vector<PerturbingBody>& bodies;
+};
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(std::size_t n_threads) :
+	task(nullptr), task_size(0), generation(0), chunks_remaining(0), first_error(nullptr), stopping(false)
+{
+	if (n_threads == 0)
+	{
+		n_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	this->thread_count = n_threads;
+
+	for (std::size_t i = 1; i < this->thread_count; i++)
+	{
+		this->workers.emplace_back(&ThreadPool::worker_loop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+//note: workers finish any queued submit() jobs before they exit
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mtx);
+		this->stopping = true;
+	}
+	this->start_cv.notify_all();
+	for (auto& worker : this->workers)
+	{
+		worker.join();
+	}
+}
+
+#pragma region getters
+std::size_t ThreadPool::get_thread_count() const
+{
+	return this->thread_count;
+}
+#pragma endregion getters
+
+#pragma region utilities
+void ThreadPool::parallel_for(std::size_t n, const std::function<void(std::size_t, std::size_t)>& task)
+{
+	if (n == 0)
+	{
+		return;
+	}
+	if (this->thread_count == 1)
+	{
+		task(0, n);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mtx);
+		this->task = &task;
+		this->task_size = n;
+		this->chunks_remaining = this->thread_count;
+		this->first_error = nullptr;
+		this->generation++;
+	}
+	this->start_cv.notify_all();
+
+	run_chunk(0); //calling thread takes the first chunk
+
+	std::unique_lock<std::mutex> lock(this->mtx);
+	this->done_cv.wait(lock, [this] { return this->chunks_remaining == 0; });
+	this->task = nullptr;
+
+	if (this->first_error)
+	{
+		std::rethrow_exception(this->first_error);
+	}
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> job)
+{
+	//packaged_task is move-only, so it's shared into the (copyable) std::function that sits in the queue
+	auto task = std::make_shared<std::packaged_task<void()>>(std::move(job));
+	std::future<void> result = task->get_future();
+	if (this->workers.empty())
+	{
+		(*task)();
+		return result;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->mtx);
+		this->jobs.emplace_back([task] { (*task)(); });
+	}
+	this->start_cv.notify_one();
+	return result;
+}
+
+void ThreadPool::worker_loop(std::size_t worker_ix)
+{
+	std::size_t seen_generation = 0;
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(this->mtx);
+			this->start_cv.wait(lock, [&] { return this->stopping || this->generation != seen_generation || !this->jobs.empty(); });
+			if (this->generation != seen_generation)
+			{
+				seen_generation = this->generation;
+			}
+			else if (!this->jobs.empty())
+			{
+				job = std::move(this->jobs.front());
+				this->jobs.pop_front();
+			}
+			else
+			{
+				return; //stopping, and every queued job has been run
+			}
+		}
+
+		if (job)
+		{
+			job(); //exceptions end up in the job's future
+		}
+		else
+		{
+			run_chunk(worker_ix);
+		}
+	}
+}
+
+void ThreadPool::run_chunk(std::size_t chunk_ix)
+{
+	//static partitioning; chunk i always covers the same indices for a given n & thread count
+	std::size_t n = this->task_size;
+	std::size_t begin = n * chunk_ix / this->thread_count;
+	std::size_t end = n * (chunk_ix + 1) / this->thread_count;
+
+	try
+	{
+		if (begin < end)
+		{
+			(*this->task)(begin, end);
+		}
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(this->mtx);
+		if (!this->first_error)
+		{
+			this->first_error = std::current_exception();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(this->mtx);
+	this->chunks_remaining--;
+	if (this->chunks_remaining == 0)
+	{
+		this->done_cv.notify_one();
+	}
+}
+#pragma endregion utilities
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <deque>
+#include <future>
+
+class ThreadPool
+{
+public:
+	//small fork-join pool; the workers stay alive between calls so a parallel_for per time step is cheap
+	//note: the calling thread always works the first chunk itself, so a pool of n threads spawns n - 1 workers
+	ThreadPool(std::size_t n_threads); //n_threads = 0 uses std::thread::hardware_concurrency()
+	~ThreadPool();
+
+	//going for a singleton-ish pattern for the ThreadPool class; don't want it to be copyable
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	//getters
+	std::size_t get_thread_count() const;
+
+	//utilities
+	void parallel_for(std::size_t n, const std::function<void(std::size_t, std::size_t)>& task);
+	//note: splits [0, n) into one contiguous [begin, end) chunk per thread and blocks until every chunk is done,
+	//      so each call doubles as a barrier. the chunk boundaries only depend on n and the thread count.
+	std::future<void> submit(std::function<void()> job);
+	//note: queues a fire-and-forget job for the next free worker; the future carries any exception it throws.
+	//      a pool without workers (1 thread) just runs the job before returning. meant for background work like
+	//      file output on its own pool; a long job holds up parallel_for chunks on the same pool
+
+private:
+	void worker_loop(std::size_t worker_ix);
+	void run_chunk(std::size_t chunk_ix);
+
+	std::vector<std::thread> workers;
+	std::size_t thread_count;
+
+	std::mutex mtx;
+	std::condition_variable start_cv;
+	std::condition_variable done_cv;
+
+	//current parallel_for job; guarded by mtx
+	const std::function<void(std::size_t, std::size_t)>* task;
+	std::size_t task_size;
+	std::size_t generation; //bumped for every new job so sleeping workers know there's work
+	std::size_t chunks_remaining;
+	std::exception_ptr first_error;
+	std::deque<std::function<void()>> jobs; //submitted jobs waiting for a worker
+	bool stopping;
+};
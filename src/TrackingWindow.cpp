@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+#include "TrackingWindow.h"
+#include <astrokit/kepler.h>
+
+TrackingWindow::TrackingWindow() : ring(), head(0), count(0), pushes_since_rebuild(0), sums{}
+{
+}
+
+#pragma region getters
+std::size_t TrackingWindow::get_size() const
+{
+	return this->count;
+}
+
+double TrackingWindow::get_last_et() const
+{
+	return (this->count > 0) ? at(this->count - 1).et : 0.0;
+}
+
+double TrackingWindow::get_span() const
+{
+	return (this->count > 0) ? std::abs(get_last_et() - at(0).et) : 0.0;
+}
+
+TrackingState TrackingWindow::get_means() const
+{
+	TrackingState means{};
+	if (this->count == 0)
+	{
+		return means;
+	}
+	double n = static_cast<double>(this->count);
+	means.et = get_last_et();
+	means.sma_mean = this->sums[0] / n;
+	means.inc_mean = this->sums[1] / n;
+	means.raan_mean = astrokit::wrap_2pi(this->sums[2] / n);
+	means.neighbor1_rel_angle = this->sums[3] / n;
+	means.neighbor2_rel_angle = this->sums[4] / n;
+	return means;
+}
+#pragma endregion getters
+
+#pragma region utilities
+void TrackingWindow::clear()
+{
+	this->head = 0;
+	this->count = 0;
+	this->pushes_since_rebuild = 0;
+	for (double& sum : this->sums)
+	{
+		sum = 0.0;
+	}
+}
+
+void TrackingWindow::push(const Sample& sample)
+{
+	if (this->count == this->ring.size())
+	{
+		grow();
+	}
+	Sample unwrapped = sample;
+	if (this->count > 0)
+	{
+		//raan is kept continuous across the window (the node precesses through 0/2pi under J2)
+		double prev_raan = at(this->count - 1).raan;
+		unwrapped.raan = prev_raan + astrokit::wrap_pi(sample.raan - prev_raan);
+	}
+	this->ring[(this->head + this->count) % this->ring.size()] = unwrapped;
+	this->count++;
+	add_to(this->sums, unwrapped, 1.0);
+
+	if (++this->pushes_since_rebuild >= this->ring.size())
+	{
+		rebuild_sums();
+	}
+}
+
+void TrackingWindow::drop_before(double et0)
+{
+	//works for backward propagation too; "before" is measured along the direction the samples are arriving in
+	while (this->count >= 2)
+	{
+		const double direction = (get_last_et() >= at(0).et) ? 1.0 : -1.0;
+		if (direction * (at(1).et - et0) > 0.0)
+		{
+			break;
+		}
+		pop_front();
+	}
+}
+
+const TrackingWindow::Sample& TrackingWindow::at(std::size_t i) const
+{
+	return this->ring[(this->head + i) % this->ring.size()];
+}
+
+void TrackingWindow::pop_front()
+{
+	add_to(this->sums, this->ring[this->head], -1.0);
+	this->head = (this->head + 1) % this->ring.size();
+	this->count--;
+}
+
+void TrackingWindow::grow()
+{
+	//only happens while the window first fills up (or if the step shrinks); unroll the ring into the bigger buffer
+	std::vector<Sample> bigger(std::max<std::size_t>(2 * this->ring.size(), 64));
+	for (std::size_t i = 0; i < this->count; i++)
+	{
+		bigger[i] = at(i);
+	}
+	this->ring.swap(bigger);
+	this->head = 0;
+}
+
+void TrackingWindow::rebuild_sums()
+{
+	double fresh[N_SUMS] = {};
+	for (std::size_t i = 0; i < this->count; i++)
+	{
+		add_to(fresh, at(i), 1.0);
+	}
+	for (int k = 0; k < N_SUMS; k++)
+	{
+		this->sums[k] = fresh[k];
+	}
+	this->pushes_since_rebuild = 0;
+}
+
+void TrackingWindow::add_to(double* sums, const Sample& sample, double sign)
+{
+	sums[0] += sign * sample.sma;
+	sums[1] += sign * sample.inc;
+	sums[2] += sign * sample.raan;
+	sums[3] += sign * sample.neighbor1_angle;
+	sums[4] += sign * sample.neighbor2_angle;
+}
+#pragma endregion utilities
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include "structure_definitions.h"
+
+class TrackingWindow
+{
+public:
+	//rolling means of the tracking quantities (see TrackingState) over a trailing time window
+	//samples sit in a ring buffer next to running sums of each quantity, so adding a sample & dropping the ones that
+	// fall out of the window are O(1) no matter how long the window is
+	//note: raan samples are unwrapped against the previous one, so a node crossing 0/2pi inside the window doesn't
+	//      wreck the mean (which comes back wrapped into [0, 2pi))
+	//note: the sums are rebuilt from the buffer each time it turns over, so rounding from the add/subtract pairs
+	//      never accumulates past one window's worth of samples
+	struct Sample
+	{
+		double et;
+		double sma;
+		double inc;
+		double raan;
+		double neighbor1_angle;
+		double neighbor2_angle;
+	};
+
+	TrackingWindow();
+
+	//getters
+	std::size_t get_size() const;
+	double get_last_et() const; //et of the newest sample
+	double get_span() const; //[s]; time between the oldest & newest samples
+	TrackingState get_means() const; //et is the newest sample's; all zero when the window is empty
+
+	//utilities
+	void clear();
+	void push(const Sample& sample);
+	void drop_before(double et0);
+	//note: keeps the newest sample at or before et0 as the oldest one, so the window spans at least back to et0
+	//      (same rows Spacecraft::get_et_index picks)
+
+private:
+	static constexpr int N_SUMS = 5;
+
+	const Sample& at(std::size_t i) const; //i-th oldest sample
+	void pop_front();
+	void grow();
+	void rebuild_sums();
+	static void add_to(double* sums, const Sample& sample, double sign);
+
+	std::vector<Sample> ring;
+	std::size_t head; //oldest sample
+	std::size_t count;
+	std::size_t pushes_since_rebuild;
+	double sums[N_SUMS]; //sma, inc, raan, neighbor1_angle, neighbor2_angle
+};
@@ -47,6 +47,7 @@ void WalkerDelta::initialize_satellites(int number_of_sats, int number_of_planes
 	// sma & inc are fixed; by definition argp=e=0
 	// need to find raan & ta for each satellite
 	//loop through the orbital planes
+	std::size_t sc_offset = get_sats().size(); //index of this shell's first spacecraft
 	for (int plane_number = 0; plane_number < number_of_planes; plane_number++)
 	{
 		double raan = raan0 + raan_spacing * plane_number; //all satellites in each plane will share the same raan
@@ -62,4 +63,19 @@ void WalkerDelta::initialize_satellites(int number_of_sats, int number_of_planes
 			add_spacecraft(sat_name, get_et(), coes);
 		}
 	}
+
+	//tracking neighbors follow the plane/slot layout above: the next slot in the same plane (in-plane phasing) and the
+	// same slot in the next plane (cross-plane phasing, which includes the F offset)
+	std::vector<TrackingNeighbors> neighbors = get_tracking_neighbors();
+	neighbors.resize(sc_offset, TrackingNeighbors{ 0, 0 });
+	for (int plane_number = 0; plane_number < number_of_planes; plane_number++)
+	{
+		for (int sat_number = 0; sat_number < sats_per_plane; sat_number++)
+		{
+			std::size_t in_plane = sc_offset + plane_number * sats_per_plane + (sat_number + 1) % sats_per_plane;
+			std::size_t cross_plane = sc_offset + ((plane_number + 1) % number_of_planes) * sats_per_plane + sat_number;
+			neighbors.push_back(TrackingNeighbors{ in_plane, cross_plane });
+		}
+	}
+	set_tracking_neighbors(neighbors);
 }
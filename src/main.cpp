@@ -36,14 +36,26 @@ int main()
 
 	//define ground station(s)
 	//for now, just using approxiamte APL lon/lat
-	earth.new_station("APL", 39.0 * astrokit::DEG2RAD, -77.0 * astrokit::DEG2RAD);
+	earth.new_station("APL", -77.0 * astrokit::DEG2RAD, 39.0 * astrokit::DEG2RAD); //new_station takes lon, then lat
 
 	//now have both our ground station and constellation satellites initialized
-	//time to propagate
+	//time to propagate; Keplerian + J2 with fixed-step RK4 can use the SIMD batch propagator
+	PropagationOptions prop_options;
+	prop_options.mode = PropagationMode::batch;
+	wd_const.set_prop_options(prop_options);
+
+	//body-fixed rotations & sun/moon positions for the whole run are precomputed once; analysis interpolates from the caches
+	earth.cache_rotations(et0, et0 + prop_time);
+	earth.cache_ephemeris(et0, et0 + prop_time, { 10, 301 });
+
 	wd_const.propagate(prop_time, prop_step);
 
-	std::cout << "Propagation finished.";
-	//NEXT STEP: Data processing, analysis, & visualization
+	std::cout << "Propagation finished.\n";
+
+	//ground station access intervals across the whole constellation
+	std::vector<AccessInterval> passes = wd_const.compute_station_access();
+	std::cout << passes.size() << " ground station passes.\n";
+	//NEXT STEP: remaining data processing, analysis, & visualization
 
 	//output csv state histories for each satellite
 	wd_const.save_spacecraft_histories("C:/constellation_sim_results/");
@@ -0,0 +1,81 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+//thin wrapper around the widest double-precision SIMD register the compiler is targeting
+//note: selected at compile time from the instruction set flags (e.g. /arch:AVX2 or -march=native, which the CMake
+//      option CONSTELLATION_SIMD_ARCH adds; the default build sets neither, so WIDTH is 1 there);
+//      falls back to plain scalar doubles when no AVX support is enabled so the same kernel code
+//      builds everywhere. only the handful of operations the batch kernels (gravity/RK4, link geometry) need are here.
+namespace simd
+{
+#if defined(__AVX512F__)
+	constexpr std::size_t WIDTH = 8;
+
+	struct vec
+	{
+		__m512d v;
+	};
+
+	inline vec load(const double* p) { return { _mm512_loadu_pd(p) }; }
+	inline void store(double* p, vec a) { _mm512_storeu_pd(p, a.v); }
+	inline vec broadcast(double s) { return { _mm512_set1_pd(s) }; }
+	inline vec sqrt(vec a) { return { _mm512_sqrt_pd(a.v) }; }
+
+	inline vec operator+(vec a, vec b) { return { _mm512_add_pd(a.v, b.v) }; }
+	inline vec operator-(vec a, vec b) { return { _mm512_sub_pd(a.v, b.v) }; }
+	inline vec operator*(vec a, vec b) { return { _mm512_mul_pd(a.v, b.v) }; }
+	inline vec operator/(vec a, vec b) { return { _mm512_div_pd(a.v, b.v) }; }
+	inline vec min(vec a, vec b) { return { _mm512_min_pd(a.v, b.v) }; }
+	inline vec max(vec a, vec b) { return { _mm512_max_pd(a.v, b.v) }; }
+#elif defined(__AVX2__) || defined(__AVX__)
+	constexpr std::size_t WIDTH = 4;
+
+	struct vec
+	{
+		__m256d v;
+	};
+
+	inline vec load(const double* p) { return { _mm256_loadu_pd(p) }; }
+	inline void store(double* p, vec a) { _mm256_storeu_pd(p, a.v); }
+	inline vec broadcast(double s) { return { _mm256_set1_pd(s) }; }
+	inline vec sqrt(vec a) { return { _mm256_sqrt_pd(a.v) }; }
+
+	inline vec operator+(vec a, vec b) { return { _mm256_add_pd(a.v, b.v) }; }
+	inline vec operator-(vec a, vec b) { return { _mm256_sub_pd(a.v, b.v) }; }
+	inline vec operator*(vec a, vec b) { return { _mm256_mul_pd(a.v, b.v) }; }
+	inline vec operator/(vec a, vec b) { return { _mm256_div_pd(a.v, b.v) }; }
+	inline vec min(vec a, vec b) { return { _mm256_min_pd(a.v, b.v) }; }
+	inline vec max(vec a, vec b) { return { _mm256_max_pd(a.v, b.v) }; }
+#else
+	constexpr std::size_t WIDTH = 1;
+
+	struct vec
+	{
+		double v;
+	};
+
+	inline vec load(const double* p) { return { *p }; }
+	inline void store(double* p, vec a) { *p = a.v; }
+	inline vec broadcast(double s) { return { s }; }
+	inline vec sqrt(vec a) { return { std::sqrt(a.v) }; }
+
+	inline vec operator+(vec a, vec b) { return { a.v + b.v }; }
+	inline vec operator-(vec a, vec b) { return { a.v - b.v }; }
+	inline vec operator*(vec a, vec b) { return { a.v * b.v }; }
+	inline vec operator/(vec a, vec b) { return { a.v / b.v }; }
+	inline vec min(vec a, vec b) { return { (b.v < a.v) ? b.v : a.v }; }
+	inline vec max(vec a, vec b) { return { (a.v < b.v) ? b.v : a.v }; }
+#endif
+
+	inline std::size_t padded_size(std::size_t n)
+	//rounds n up to a whole number of SIMD lanes
+	{
+		return ((n + WIDTH - 1) / WIDTH) * WIDTH;
+	}
+
+} // namespace simd
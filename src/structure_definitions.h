@@ -1,7 +1,11 @@
 
 #pragma once
+#include <memory>
+#include <vector>
 #include <Eigen/Dense>
 
+class HistorySink; //see HistorySink.h
+
 struct State //Contains both the cartesian (ICRF) state and the orbital elements for each time step, et
 {
 	double et;
@@ -43,6 +47,12 @@ struct COE //using this to store reference conic trajectories
 	double ta;
 };
 
+struct TrackingNeighbors //which spacecraft TrackingState's phase angles are measured against (indices into the constellation's spacecraft list)
+{
+	std::size_t neighbor1; //in-plane; the next spacecraft along the same plane for Walker constellations
+	std::size_t neighbor2; //cross-plane; the same slot in the next plane for Walker constellations
+};
+
 struct BoundingBox //orbital element bounding boxes for members of constellation
 //note: using orbital element bounds instead of RTN for this simulation
 {
@@ -51,3 +61,151 @@ struct BoundingBox //orbital element bounding boxes for members of constellation
 	double draan;
 	double darglat;
 };
+
+struct BoundsCheck //which bounding box checks a spacecraft is failing (see Spacecraft::check_bounds)
+{
+	bool sma = false;
+	bool inc = false;
+	bool raan = false;
+	bool arglat = false; //phasing against the in-plane tracking neighbor
+
+	bool any() const { return sma || inc || raan || arglat; }
+};
+
+enum class ManeuverType //what a scheduled station-keeping burn is correcting
+{
+	sma,           //tangential burn back to the reference mean sma
+	plane,         //normal burn at the argument of latitude that fixes inc & raan together
+	phasing_start, //tangential burn that starts a drift back to the reference phasing
+	phasing_stop   //equal & opposite burn that ends the drift
+};
+
+struct Maneuver //impulsive burn; queued by ManeuverScheduler, then logged in its ledger once executed
+{
+	double et; //scheduled epoch (the epoch it was actually applied at, in the ledger)
+	std::size_t sc_index; //index into the constellation's spacecraft list
+	ManeuverType type;
+	Eigen::Vector3d dv_rtn; //[km/s]; radial, transverse (along-track), normal components at the burn
+};
+
+enum class EventDirection //which sign changes of an event function count (see EventDetector)
+{
+	any,
+	rising, //negative to positive
+	falling //positive to negative
+};
+
+struct EventRecord //one located root of an event function along a spacecraft's trajectory
+{
+	std::size_t sc_index; //index into the constellation's spacecraft list
+	std::size_t event_index; //index into the constellation's event list (order of add_event)
+	double et;
+	bool rising; //the event function went from negative to positive
+	Eigen::Vector<double, 6> state; //interpolated icrf cartesian state at et
+};
+
+struct AccessInterval //one pass of a spacecraft over a ground station (elevation >= the station's mask)
+{
+	std::size_t sc_index;      //index into the constellation's spacecraft list
+	std::size_t station_index; //index into the central body's station list
+	double rise_et; //AOS; the start of the history if the pass was already underway
+	double set_et;  //LOS; the end of the history if the pass was still underway
+	double max_elevation; //[rad]; highest elevation among the history samples inside the pass
+};
+
+struct LinkSample //inter-satellite geometry for one pair of spacecraft at one output epoch
+{
+	std::size_t sc_a; //index into the constellation's spacecraft list (sc_a < sc_b)
+	std::size_t sc_b;
+	double et;
+	double range;      //[km]
+	double range_rate; //[km/s]; positive when the pair is separating
+	double grazing_altitude; //[km]; lowest altitude of the line of sight above the (spherical) central body
+	bool line_of_sight; //grazing_altitude >= the analyzer's grazing margin
+	bool linked;        //line of sight & within the analyzer's max range
+};
+
+struct LinkInterval //one span of time a pair of spacecraft can hold a link
+{
+	std::size_t sc_a; //sc_a < sc_b
+	std::size_t sc_b;
+	double start_et; //the start of the history if the link was already up
+	double end_et;   //the end of the history if the link was still up
+	double min_range; //[km]; closest approach among the history samples inside the interval
+};
+
+enum class ShadowType
+{
+	penumbra, //any part of the sun's disk is blocked (umbra included)
+	umbra //all of it
+};
+
+struct EclipseInterval //one pass of a spacecraft through the central body's shadow
+{
+	std::size_t sc_index; //index into the constellation's spacecraft list
+	ShadowType type;
+	double start_et; //shadow entry; the start of the history if it was already in shadow
+	double end_et;   //shadow exit; the end of the history if it was still in shadow
+};
+
+struct EclipseReport //shadow & sun geometry for a whole constellation over its output epochs (see EclipseAnalyzer)
+{
+	std::vector<double> et; //output epochs
+	std::vector<EclipseInterval> eclipses; //ordered by spacecraft, then start time; every umbra interval sits inside a penumbra one
+	std::vector<std::size_t> plane_index; //orbit plane of each spacecraft
+	std::vector<std::vector<double>> beta; //[rad]; per orbit plane, one per output epoch; sun elevation above the plane
+};
+
+struct PerturbingBody //third body included in the force model as a point mass
+{
+	int spkid;
+	double mu; //[km^3/s^2]
+};
+
+enum class PropagationMode //how Constellation::propagate steps its spacecraft
+{
+	per_spacecraft, //each Spacecraft steps itself through the Integrator (original behavior)
+	batch,          //all states packed into a BatchPropagator and stepped together with SIMD (Keplerian + J2, fixed-step RK4 only)
+	mean_j2         //analytic J2 secular drift of the mean elements; no integration, O(1) per sample (survey/design sweeps)
+	//note: mean_j2 only knows point-mass + J2 (ForceModel::get_include_j2); propagate throws if the force model has
+	//      spherical harmonics or third bodies, same as batch
+};
+
+struct PropagationOptions
+{
+	PropagationMode mode = PropagationMode::per_spacecraft;
+	std::size_t num_threads = 1; //worker threads used to step the spacecraft; 0 = one per hardware thread
+	//note: every spacecraft is stepped by exactly the same operations regardless of which thread runs it, so the
+	//      histories are bit-identical for any thread count
+
+	bool dense_output = false; //decouple the integration step from the output step; outputs are interpolated per step
+	double integration_step = 0.0; //[s]; fixed RK4 step used with dense_output (0 = same as the output step)
+	//note: adaptive integrators pick their own steps with dense_output; integration_step is ignored for them
+
+	bool analytic_two_body = true; //with a two-body-only force model, propagate with the closed-form Kepler solution instead of integrating
+	//note: applies to the per_spacecraft & batch modes; the states are exact at every output epoch, independent of the step
+
+	bool record_coe_history = true; //false skips the orbital element history entirely (cartesian only)
+
+	std::size_t num_io_threads = 2; //background threads used to write history files (0 = write on the calling thread)
+
+	std::shared_ptr<HistorySink> history_sink; //nullptr keeps the whole history in memory (original behavior)
+	std::size_t stream_chunk_rows = 4096; //output steps between flushes to history_sink
+	//note: when streaming, each spacecraft only keeps a recent window in memory, sized to cover at least one reference
+	//      period so update_tracking still has a full averaging window
+
+	bool station_keeping = false; //keep every spacecraft inside the constellation's sc_bounds while propagating
+	//note: after each output step the constellation updates tracking (see Constellation::update_tracking), checks each
+	//      spacecraft against sc_bounds & queues burns for any violations, then applies the burns that are due.
+	//      burns land on output epochs, so the output step sets their timing resolution. stepping modes only (the
+	//      closed-form two-body shortcut is skipped; mean_j2 can't apply burns). an output epoch with burns gets one
+	//      extra zero-length history row on every spacecraft (post-burn state for the burners, a repeat for the rest)
+	double maneuver_lead_time = 0.0; //[s]; earliest a burn can happen after the violation is detected (planning/upload time)
+	double phasing_drift_periods = 10.0; //reference periods a phasing correction is given to drift back into place
+};
+
+enum class HistoryFormat //file format used by Constellation::save_spacecraft_histories
+{
+	csv,   //human-readable text, one row per output step
+	binary //columnar little-endian doubles with a small header; read back with HistoryFile (memory-mapped)
+};
@@ -0,0 +1,99 @@
+/*
+Closed-form propagation epochs
+
+The closed-form modes sample each spacecraft at offsets from the start of the call; every sample has to be stamped
+with the spacecraft's own epoch (like the stepping modes' sc.get_et() + dt), not the constellation clock. Spacecraft
+are created at epochs away from the clock on purpose, and the closed-form histories are compared row by row against
+fixed-step RK4 on the same force model (two-body, so mean_j2's mean elements are the osculating ones and it's held to
+the same comparison). mean_j2 also has to refuse force models it can't represent.
+*/
+
+#include <stdexcept>
+#include "Constellation.h"
+#include <astrokit/constants.h>
+#include "test_utils.h"
+
+namespace
+{
+	constexpr double LATE_ET = 5000.0; //[s]; the constellation clock stays at 0
+	constexpr double DURATION = 12000.0; //[s]; ~2 LEO orbits
+	constexpr double STEP = 10.0; //[s]
+
+	std::vector<Spacecraft> propagate(Planet& earth, Integrator& integrator, PropagationOptions options)
+	{
+		Constellation constellation(earth, integrator);
+		Eigen::Vector3d pos0(6928.0, 0.0, 0.0);
+		Eigen::Vector3d vel0(0.0, 4.5, 6.0);
+		constellation.add_spacecraft("late", LATE_ET, pos0, vel0);
+		constellation.add_spacecraft("on_clock", 0.0, pos0, vel0);
+		constellation.set_prop_options(options);
+		constellation.propagate(DURATION, STEP);
+		return constellation.get_sats();
+	}
+
+	void compare_histories(const std::vector<Spacecraft>& test, const std::vector<Spacecraft>& reference, double pos_tol)
+	{
+		for (std::size_t i = 0; i < reference.size(); i++)
+		{
+			const HistoryArena& a = test[i].get_history();
+			const HistoryArena& b = reference[i].get_history();
+			if (!CHECK(a.get_rows() == b.get_rows()))
+			{
+				continue;
+			}
+			double worst_dt = 0.0;
+			double worst_pos = 0.0;
+			for (std::size_t k = 0; k < a.get_rows(); k++)
+			{
+				worst_dt = std::max(worst_dt, std::abs(a.et_at(k) - b.et_at(k)));
+				worst_pos = std::max(worst_pos, (a.cart_at(k).head<3>() - b.cart_at(k).head<3>()).norm());
+			}
+			CHECK(worst_dt == 0.0);
+			CHECK_CLOSE(worst_pos, 0.0, pos_tol);
+			CHECK(test[i].get_et() == reference[i].get_et());
+		}
+		CHECK(test[0].get_history().et_at(0) == LATE_ET);
+		CHECK_CLOSE(test[0].get_et(), LATE_ET + DURATION, 1e-9);
+		CHECK_CLOSE(test[1].get_et(), DURATION, 1e-9);
+	}
+}
+
+int main()
+{
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+	ForceModel two_body(earth, false);
+	Integrator rk4(earth, two_body);
+
+	//reference: RK4 through the per-spacecraft stepping path
+	PropagationOptions stepped;
+	stepped.analytic_two_body = false;
+	std::vector<Spacecraft> reference = propagate(earth, rk4, stepped);
+
+	//closed-form Kepler path (the default with a two-body force model)
+	PropagationOptions analytic;
+	compare_histories(propagate(earth, rk4, analytic), reference, 1e-2);
+
+	//mean_j2 on the same grid; no J2 in this force model, so the mean & osculating two-body orbits are the same one
+	PropagationOptions mean_j2;
+	mean_j2.mode = PropagationMode::mean_j2;
+	std::vector<Spacecraft> mean = propagate(earth, rk4, mean_j2);
+	compare_histories(mean, reference, 1e-2);
+
+	//mean_j2 can't model third bodies (or spherical harmonics); it has to say so rather than quietly drop them
+	ForceModel with_sun(earth, true);
+	with_sun.add_third_body(10, astrokit::MU_SUN_km3_s2);
+	Integrator rk4_sun(earth, with_sun);
+	bool threw = false;
+	try
+	{
+		propagate(earth, rk4_sun, mean_j2);
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+
+	return test::finish("test_closed_form_epochs");
+}
@@ -0,0 +1,74 @@
+/*
+RKF78 continuous extension
+
+Integrator::dense_step hands back a continuous extension of every step, which Spacecraft::advance_to samples for the
+outputs in dense_output mode. RKF78 takes long steps, so the extension (quintic orbit Hermite, with its mid-step defect
+held to the tolerances) has to stay within the integrator's tolerances everywhere inside a step, not just at the ends.
+Each step of a two-body orbit is checked against the closed-form Kepler solution from that step's start state, so only
+the step's own (local + interpolation) error is measured.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include "Integrator.h"
+#include <astrokit/constants.h>
+#include <astrokit/kepler.h>
+#include "test_utils.h"
+
+namespace
+{
+	void check_orbit(Integrator& integrator, double mu, double rp, double e, double tol)
+	{
+		const double a = rp / (1.0 - e);
+		const double vp = std::sqrt(mu * (2.0 / rp - 1.0 / a));
+		const double period = 2.0 * astrokit::PI * std::sqrt(a * a * a / mu);
+
+		Eigen::Vector<double, 6> y;
+		y << rp, 0.0, 0.0, 0.0, 0.6 * vp, 0.8 * vp;
+		Eigen::Vector<double, 6> deriv = integrator.eoms(0.0, y);
+		astrokit::DenseStep<Eigen::Vector<double, 6>> dense;
+
+		double t = 0.0;
+		double dt = period; //let the controller (& the cap) pick
+		double worst = 0.0;
+		std::size_t n_steps = 0;
+		while (t < period)
+		{
+			const Eigen::Vector<double, 6> y0 = y;
+			double dt_next;
+			y = integrator.dense_step(t, dt, y0, deriv, dense, dt_next);
+			for (int k = 1; k < 10; k++)
+			{
+				double tk = t + 0.1 * k * dt;
+				Eigen::Vector<double, 6> exact = astrokit::propagate_kepler(y0, tk - t, mu);
+				Eigen::Vector<double, 6> err = dense.evaluate(tk) - exact;
+				worst = std::max(worst, err.segment<3>(0).norm() / (tol + tol * exact.segment<3>(0).norm()));
+				worst = std::max(worst, err.segment<3>(3).norm() / (tol + tol * exact.segment<3>(3).norm()));
+			}
+			t += dt;
+			dt = dt_next;
+			n_steps++;
+		}
+
+		std::printf("  rp %.0f km, e %.1f: %zu steps/orbit, worst interpolation error %.2f x tolerance\n", rp, e, n_steps, worst);
+		CHECK(worst <= 2.0); //the defect estimate is approximate; well under 1 in practice
+	}
+}
+
+int main()
+{
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+	ForceModel two_body(earth, false);
+	const double mu = earth.get_mu();
+
+	for (double tol : { 1e-8, 1e-11 })
+	{
+		Integrator rkf78(earth, two_body, IntegrationMethod::rkf78, tol, tol);
+		check_orbit(rkf78, mu, 6800.0, 0.0, tol); //LEO
+		check_orbit(rkf78, mu, 6800.0, 0.6, tol); //eccentric, fast perigee pass
+		check_orbit(rkf78, mu, 42164.0, 0.0, tol); //GEO
+	}
+
+	return test::finish("test_dense_output");
+}
@@ -0,0 +1,140 @@
+/*
+Spherical harmonic gravity reference checks
+
+The Cunningham recursion in GravityField is checked against the closed forms it has to reduce to:
+	- degree 0/1 (and any field with every coefficient zero) adds nothing, so the harmonic kernel is pure Kepler
+	- a field holding only C20 = -J2 / sqrt(5) is the J2 field, so it has to match astrokit::accel_j2 everywhere,
+	  including near the poles & at every truncation degree/order above 2
+Both are checked on GravityField::accel directly (body-fixed) & through ForceModel's fused kernel, where the field is
+loaded from a headerless table via Planet::load_gravity_field.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "ForceModel.h"
+#include <astrokit/constants.h>
+#include <astrokit/force_models.h>
+#include "test_utils.h"
+
+namespace
+{
+	constexpr int MAX_DEGREE = 12;
+	constexpr double REL_TOL = 1e-12;
+
+	std::vector<Eigen::Vector3d> sample_positions()
+	{
+		//LEO to GEO, equator to (almost) the poles, every quadrant
+		std::vector<Eigen::Vector3d> positions;
+		for (double radius : { 6678.0, 7378.0, 12000.0, 42164.0 })
+		{
+			for (double lat_deg : { -89.9, -60.0, -20.0, 0.0, 10.0, 45.0, 75.0, 89.9 })
+			{
+				for (double lon_deg : { -135.0, 0.0, 30.0, 170.0 })
+				{
+					double lat = lat_deg * astrokit::DEG2RAD;
+					double lon = lon_deg * astrokit::DEG2RAD;
+					positions.emplace_back(radius * std::cos(lat) * std::cos(lon), radius * std::cos(lat) * std::sin(lon), radius * std::sin(lat));
+				}
+			}
+		}
+		return positions;
+	}
+
+	Eigen::Vector3d j2_reference(const Eigen::Vector3d& r)
+	{
+		Eigen::Vector<double, 6> state;
+		state << r, Eigen::Vector3d::Zero();
+		return astrokit::accel_j2(state, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2).segment<3>(3);
+	}
+
+	void check_field(const GravityField& j2_field, const GravityField& zero_field)
+	{
+		for (const Eigen::Vector3d& r : sample_positions())
+		{
+			//Kepler limit: nothing below degree 2, nothing from a zero field
+			CHECK(j2_field.accel(r, 0, 0).isZero(0.0));
+			CHECK(j2_field.accel(r, 1, 1).isZero(0.0));
+			CHECK(zero_field.accel(r, MAX_DEGREE, MAX_DEGREE).isZero(0.0));
+
+			//J2 limit at every truncation (the higher terms are all zero)
+			const Eigen::Vector3d a_j2 = j2_reference(r);
+			for (int degree = 2; degree <= MAX_DEGREE; degree++)
+			{
+				for (int order : { 0, 1, degree })
+				{
+					CHECK_CLOSE((j2_field.accel(r, degree, order) - a_j2).norm() / a_j2.norm(), 0.0, REL_TOL);
+				}
+			}
+		}
+	}
+
+	void write_j2_table(const char* file_name)
+	{
+		std::ofstream table(file_name);
+		table.precision(17);
+		for (int n = 2; n <= MAX_DEGREE; n++)
+		{
+			for (int m = 0; m <= n; m++)
+			{
+				table << n << " " << m << " " << ((n == 2 && m == 0) ? -astrokit::EARTH.J2 / std::sqrt(5.0) : 0.0) << " 0.0\n";
+			}
+		}
+	}
+
+	template <typename Kernel>
+	Eigen::Vector<double, 6> eval(const Kernel& kernel, double t, const Eigen::Vector3d& r)
+	{
+		Eigen::Vector<double, 6> state;
+		state << r, 1.0, -2.0, 3.0;
+		return kernel(t, state);
+	}
+
+	void check_force_model(Planet& earth)
+	{
+		ForceModel kepler(earth, false);
+		ForceModel j2(earth, true);
+		ForceModel harmonics(earth, false);
+		ForceModel truncated(earth, false);
+		harmonics.set_gravity_degree(MAX_DEGREE, MAX_DEGREE);
+		truncated.set_gravity_degree(2, 0);
+
+		for (double et : { 0.0, 3600.0, 86400.0 * 3.3 })
+		{
+			for (const Eigen::Vector3d& r : sample_positions())
+			{
+				auto d_kep = kepler.with_kernel([&](const auto& f) { return eval(f, et, r); });
+				auto d_j2 = j2.with_kernel([&](const auto& f) { return eval(f, et, r); });
+				const double scale = (d_j2 - d_kep).segment<3>(3).norm();
+				for (const ForceModel* fm : { &harmonics, &truncated })
+				{
+					auto d = fm->with_kernel([&](const auto& f) { return eval(f, et, r); });
+					CHECK(d.segment<3>(0) == d_j2.segment<3>(0));
+					CHECK_CLOSE((d - d_j2).segment<3>(3).norm() / scale, 0.0, 1e-9); //relative to the J2 part itself
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+
+	GravityField j2_field(astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_EQUATOR_km, MAX_DEGREE);
+	j2_field.set_coefficients(2, 0, -astrokit::EARTH.J2 / std::sqrt(5.0), 0.0);
+	GravityField zero_field(astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_EQUATOR_km, MAX_DEGREE);
+	check_field(j2_field, zero_field);
+
+	//same field through a file & the planet's rotation into the body-fixed frame (J2 is axisymmetric, so the
+	// rotation can't change the answer)
+	const char* table = "test_gravity_field_j2.tbl";
+	write_j2_table(table);
+	earth.load_gravity_field(table, MAX_DEGREE, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_EQUATOR_km);
+	std::remove(table);
+	check_force_model(earth);
+
+	return test::finish("test_gravity_field");
+}
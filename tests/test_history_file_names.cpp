@@ -0,0 +1,154 @@
+/*
+History file names
+
+Spacecraft names can repeat, and a repeat with a counter appended can land on another spacecraft's own name ("s", "s",
+"s1"). Every writer has to come up with one distinct file per spacecraft anyway, or two streams end up in the same file:
+	- HistoryFileSink streaming chunks for each spacecraft
+	- Constellation::save_spacecraft_histories, where every file is its own I/O job (binary & csv)
+Each file is read back & has to hold its own spacecraft's rows.
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#include "HistorySink.h"
+#include "HistoryFile.h"
+#include "Constellation.h"
+#include <astrokit/constants.h>
+#include "test_utils.h"
+
+namespace
+{
+	const std::vector<std::string> NAMES{ "s", "s", "s1" };
+	constexpr std::size_t N_ROWS = 5;
+
+	HistoryArena make_history(std::size_t sc_index)
+	{
+		//every value tagged with the spacecraft index so a file holding someone else's rows shows up
+		HistoryArena history(false);
+		for (std::size_t k = 0; k < N_ROWS; k++)
+		{
+			Eigen::Vector<double, 6> cart = Eigen::Vector<double, 6>::Constant(100.0 * sc_index + k);
+			history.append(10.0 * k, cart);
+		}
+		return history;
+	}
+
+	void check_files(const std::vector<std::string>& filenames)
+	{
+		if (!CHECK(filenames.size() == NAMES.size()))
+		{
+			return;
+		}
+		CHECK(std::set<std::string>(filenames.begin(), filenames.end()).size() == NAMES.size());
+		for (std::size_t i = 0; i < filenames.size(); i++)
+		{
+			HistoryFile file(filenames[i]);
+			CHECK(file.get_name() == NAMES[i]);
+			if (CHECK(file.get_rows() == N_ROWS))
+			{
+				for (std::size_t k = 0; k < N_ROWS; k++)
+				{
+					CHECK(file.column("et")[k] == 10.0 * k);
+					CHECK(file.column("rx")[k] == 100.0 * i + k);
+				}
+			}
+		}
+		for (const std::string& filename : filenames)
+		{
+			std::remove(filename.c_str());
+		}
+	}
+
+	void check_sink()
+	{
+		HistoryFileSink sink("test_names_sink_");
+		std::vector<HistoryArena> histories;
+		for (std::size_t i = 0; i < NAMES.size(); i++)
+		{
+			histories.push_back(make_history(i));
+			sink.reserve(i, NAMES[i], false, N_ROWS);
+		}
+		//two chunks each, interleaved across spacecraft like Constellation::stream_histories
+		for (std::size_t first : { std::size_t(0), std::size_t(2) })
+		{
+			for (std::size_t i = 0; i < NAMES.size(); i++)
+			{
+				std::size_t n = (first == 0) ? 2 : N_ROWS - 2;
+				sink.write(i, NAMES[i], first, histories[i].block(first, n, 0, histories[i].get_cols()));
+			}
+		}
+		sink.finish();
+		check_files(sink.get_filenames());
+	}
+
+	std::size_t count_lines(const std::string& filename)
+	{
+		std::ifstream f(filename);
+		std::size_t n = 0;
+		for (std::string line; std::getline(f, line);)
+		{
+			n++;
+		}
+		return n;
+	}
+
+	void check_save(Planet& earth, Integrator& integrator)
+	{
+		Constellation constellation(earth, integrator);
+		for (std::size_t i = 0; i < NAMES.size(); i++)
+		{
+			constellation.add_spacecraft(NAMES[i], 0.0, Eigen::Vector3d(7000.0 + 100.0 * i, 0.0, 0.0), Eigen::Vector3d(0.0, 4.5, 6.0));
+		}
+		PropagationOptions options;
+		options.num_io_threads = 3; //one writer per file, all at once
+		constellation.set_prop_options(options);
+		constellation.propagate(10.0 * (N_ROWS - 1), 10.0);
+		const std::vector<Spacecraft>& sats = constellation.get_sats();
+
+		//binary: each file has to hold the spacecraft it's named after (s, s1, then s11 for the "s1" that lost its name)
+		const std::vector<std::string> stems{ "test_names_save_s", "test_names_save_s1", "test_names_save_s11" };
+		constellation.save_spacecraft_histories("test_names_save_", HistoryFormat::binary);
+		std::vector<std::string> filenames;
+		for (std::size_t i = 0; i < NAMES.size(); i++)
+		{
+			filenames.push_back(stems[i] + ".bin");
+			HistoryFile file(filenames.back());
+			CHECK(file.get_name() == NAMES[i]);
+			if (CHECK(file.get_rows() == sats[i].get_history().get_rows()))
+			{
+				for (std::size_t k = 0; k < file.get_rows(); k++)
+				{
+					CHECK(file.column("rx")[k] == sats[i].get_history().cart_at(k)[0]);
+				}
+			}
+		}
+
+		//csv: same names, one header line plus one line per row
+		constellation.save_spacecraft_histories("test_names_save_", HistoryFormat::csv);
+		for (std::size_t i = 0; i < NAMES.size(); i++)
+		{
+			filenames.push_back(stems[i] + ".csv");
+			CHECK(count_lines(filenames.back()) == sats[i].get_history().get_rows() + 1);
+		}
+
+		for (const std::string& filename : filenames)
+		{
+			std::remove(filename.c_str());
+		}
+	}
+}
+
+int main()
+{
+	check_sink();
+
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+	ForceModel two_body(earth, false);
+	Integrator rk4(earth, two_body);
+	check_save(earth, rk4);
+	return test::finish("test_history_file_names");
+}
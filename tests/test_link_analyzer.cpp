@@ -0,0 +1,115 @@
+/*
+Inter-satellite link pruning
+
+LinkAnalyzer only evaluates the pairs its grid & pre-culls (range, horizons) let through, so it has to find exactly the
+links a brute-force check of every pair finds. Three shells at different altitudes (so one end's horizon is much wider
+than the other's) are checked at every output epoch, with & without a terminal range limit:
+	- the linked pairs from compute_geometry match the brute-force set
+	- compute_links' intervals cover exactly the epochs each pair is linked at
+	- compute_links gives identical intervals for any thread count
+*/
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include "WalkerDelta.h"
+#include <astrokit/constants.h>
+#include "test_utils.h"
+
+namespace
+{
+	constexpr double GRAZING_MARGIN = 100.0; //[km]
+	constexpr double BORDERLINE = 1e-6; //[km]; pairs this close to the link margin can go either way on rounding
+
+	double brute_force_margin(const Planet& cb, const Eigen::Vector3d& ra, const Eigen::Vector3d& rb, double max_range)
+	{
+		//same definition as LinkAnalyzer: the segment's closest approach to the body has to clear the margin
+		const Eigen::Vector3d d = rb - ra;
+		const double s = std::clamp(-ra.dot(d) / d.squaredNorm(), 0.0, 1.0);
+		double margin = (ra + s * d).norm() - cb.get_mean_radius() - GRAZING_MARGIN;
+		if (max_range > 0.0)
+		{
+			margin = std::min(margin, max_range - d.norm());
+		}
+		return margin;
+	}
+
+	void check_links(Planet& cb, const std::vector<Spacecraft>& sats, double max_range)
+	{
+		LinkAnalyzer links(cb, max_range, GRAZING_MARGIN, 1e-3);
+		ThreadPool serial(1);
+		ThreadPool threaded(3);
+		std::vector<LinkInterval> intervals = links.compute_links(sats, serial);
+		std::vector<LinkInterval> intervals_threaded = links.compute_links(sats, threaded);
+
+		if (CHECK(intervals.size() == intervals_threaded.size()))
+		{
+			for (std::size_t k = 0; k < intervals.size(); k++)
+			{
+				const LinkInterval& a = intervals[k];
+				const LinkInterval& b = intervals_threaded[k];
+				CHECK(a.sc_a == b.sc_a && a.sc_b == b.sc_b && a.start_et == b.start_et && a.end_et == b.end_et && a.min_range == b.min_range);
+			}
+		}
+
+		const std::size_t n_rows = sats[0].get_history().get_rows();
+		std::size_t n_linked = 0;
+		for (std::size_t row = 0; row < n_rows; row++)
+		{
+			const double et = sats[0].get_history().et_at(row);
+			std::set<std::pair<std::size_t, std::size_t>> geometry_linked;
+			for (const LinkSample& sample : links.compute_geometry(sats, row))
+			{
+				if (sample.linked)
+				{
+					geometry_linked.insert({ sample.sc_a, sample.sc_b });
+				}
+			}
+			std::set<std::pair<std::size_t, std::size_t>> interval_linked;
+			for (const LinkInterval& interval : intervals)
+			{
+				if (interval.start_et <= et && et <= interval.end_et)
+				{
+					interval_linked.insert({ interval.sc_a, interval.sc_b });
+				}
+			}
+
+			for (std::size_t a = 0; a < sats.size(); a++)
+			{
+				for (std::size_t b = a + 1; b < sats.size(); b++)
+				{
+					const double margin = brute_force_margin(cb, sats[a].get_history().cart_at(row).head<3>(),
+															 sats[b].get_history().cart_at(row).head<3>(), max_range);
+					if (std::abs(margin) < BORDERLINE)
+					{
+						continue;
+					}
+					const bool linked = margin >= 0.0;
+					n_linked += linked;
+					CHECK(geometry_linked.count({ a, b }) == static_cast<std::size_t>(linked));
+					CHECK(interval_linked.count({ a, b }) == static_cast<std::size_t>(linked));
+				}
+			}
+		}
+		CHECK(n_linked > 0);
+	}
+}
+
+int main()
+{
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+	ForceModel two_body(earth, false);
+	Integrator rk4(earth, two_body);
+
+	//LEO, higher LEO & MEO shells in one constellation
+	WalkerDelta shells(earth, rk4, 0.0, 120, 12, 1, 53.0 * astrokit::DEG2RAD, astrokit::EARTH.R_EQUATOR_km + 550.0);
+	shells.initialize_satellites(60, 6, 2, 70.0 * astrokit::DEG2RAD, astrokit::EARTH.R_EQUATOR_km + 1200.0, 0.3);
+	shells.initialize_satellites(24, 3, 1, 56.0 * astrokit::DEG2RAD, astrokit::EARTH.R_EQUATOR_km + 8000.0, 0.1);
+	shells.propagate(5400.0, 60.0);
+
+	check_links(earth, shells.get_sats(), 0.0); //line of sight only
+	check_links(earth, shells.get_sats(), 3000.0); //terminal range limit
+
+	return test::finish("test_link_analyzer");
+}
@@ -0,0 +1,121 @@
+/*
+SPICE from worker threads
+
+Every CSPICE call goes through SpiceHandler's process-wide lock, so queries from any number of threads have to give the
+same answers as the same queries made serially. Runs fetch_pos/fetch_state, fetch_rot_matrix, frame lookups & the
+cache builders (RotationCache, EphemerisCache) from several threads at once, with kernel reloads mixed in, and compares
+everything bit for bit against serial results.
+
+Needs the kernels SpiceHandler loads by default (../kernels/ relative to the working directory).
+*/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "SpiceHandler.h"
+#include "RotationCache.h"
+#include "EphemerisCache.h"
+#include "test_utils.h"
+
+namespace
+{
+	constexpr int N_THREADS = 8;
+	constexpr int N_SAMPLES = 2000;
+	constexpr double SPAN = 86400.0 * 2.0; //[s]
+
+	struct Results //everything one thread (or the serial pass) gets back from SPICE
+	{
+		std::vector<Eigen::Vector3d> moon_pos;
+		std::vector<Eigen::Vector3d> sun_vel;
+		std::vector<Eigen::Matrix3d> rotations;
+		int frame_id = 0;
+		std::vector<Eigen::Matrix3d> cached_rotations;
+		std::vector<Eigen::Vector3d> cached_sun;
+	};
+
+	double sample_et(double et0, int k)
+	{
+		return et0 + SPAN * static_cast<double>(k) / N_SAMPLES;
+	}
+
+	void query_everything(const SpiceHandler& spice, double et0, Results& out)
+	{
+		for (int k = 0; k < N_SAMPLES; k++)
+		{
+			double et = sample_et(et0, k);
+			out.moon_pos.push_back(spice.fetch_pos(et, 301, 399, "J2000"));
+			out.sun_vel.push_back(spice.fetch_state(et, 10, 399, "J2000")[1]);
+			out.rotations.push_back(spice.fetch_rot_matrix(et, "J2000", "IAU_EARTH"));
+		}
+		out.frame_id = spice.frame_id("IAU_EARTH");
+	}
+
+	void build_caches(SpiceHandler& spice, double et0, Results& out)
+	{
+		RotationCache rotations(spice, "J2000", "IAU_EARTH", et0, et0 + SPAN);
+		EphemerisCache ephemeris(spice, { 10, 301 }, 399, "J2000", et0, et0 + SPAN);
+		for (int k = 0; k < N_SAMPLES; k += 10)
+		{
+			double et = sample_et(et0, k);
+			out.cached_rotations.push_back(rotations.rotation(et));
+			out.cached_sun.push_back(ephemeris.position(10, et));
+		}
+	}
+
+	void compare(const Results& serial, const Results& threaded)
+	{
+		CHECK(threaded.moon_pos == serial.moon_pos);
+		CHECK(threaded.sun_vel == serial.sun_vel);
+		CHECK(threaded.rotations == serial.rotations);
+		CHECK(threaded.frame_id == serial.frame_id);
+		CHECK(threaded.cached_rotations == serial.cached_rotations);
+		CHECK(threaded.cached_sun == serial.cached_sun);
+	}
+}
+
+int main()
+{
+	SpiceHandler spice;
+	double et0 = spice.str_date_to_et("Jan 01 2026 00:00:000");
+
+	Results serial;
+	query_everything(spice, et0, serial);
+	build_caches(spice, et0, serial);
+
+	//same work from every thread at once (released together so the calls really overlap); thread 0 also reloads the
+	// kernels part way through, which nobody else should ever notice
+	for (int repeat = 0; repeat < 3; repeat++)
+	{
+		std::vector<Results> threaded(N_THREADS);
+		std::atomic<bool> go{ false };
+		std::vector<std::thread> threads;
+		for (int t = 0; t < N_THREADS; t++)
+		{
+			threads.emplace_back([&, t]
+			{
+				while (!go.load())
+				{
+					std::this_thread::yield();
+				}
+				query_everything(spice, et0, threaded[t]);
+				if (t == 0)
+				{
+					spice.reload_kernels();
+				}
+				build_caches(spice, et0, threaded[t]);
+			});
+		}
+		go.store(true);
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (const auto& results : threaded)
+		{
+			compare(serial, results);
+		}
+	}
+
+	return test::finish("test_spice_threads");
+}
@@ -0,0 +1,104 @@
+/*
+Station-keeping burns in the history
+
+Burns are applied between output steps, so the history has to hold the post-burn state as its own zero-length row or
+every interpolant (events, eclipses, links, access) across the next step would straddle the velocity jump. A Walker
+shell held in a tight box is propagated long enough to burn, in both stepping modes, and every history is checked:
+	- every spacecraft stays on the same rows & epochs (lockstep), burning or not
+	- each burn shows up as a second row at the burn epoch: same position, velocity changed by the burn; everyone else
+	  repeats their row unchanged
+	- the step after a burn starts from that post-burn row (re-stepping it reproduces the next row)
+*/
+
+#include <cmath>
+#include <cstdio>
+#include "WalkerDelta.h"
+#include <astrokit/constants.h>
+#include "test_utils.h"
+
+namespace
+{
+	constexpr double STEP = 60.0; //[s]
+
+	void check_histories(const WalkerDelta& shell, Integrator& rk4, double step_tol)
+	{
+		const std::vector<Spacecraft>& sats = shell.get_sats();
+		const std::vector<Maneuver>& ledger = shell.get_maneuvers().get_ledger();
+		std::printf("  %zu burns\n", ledger.size());
+		CHECK(!ledger.empty());
+
+		const HistoryArena& h0 = sats[0].get_history();
+		for (std::size_t i = 0; i < sats.size(); i++)
+		{
+			const HistoryArena& h = sats[i].get_history();
+			if (!CHECK(h.get_rows() == h0.get_rows()))
+			{
+				continue;
+			}
+			std::size_t n_repeats = 0;
+			for (std::size_t k = 0; k + 1 < h.get_rows(); k++)
+			{
+				CHECK(h.et_at(k) == h0.et_at(k));
+				if (h.et_at(k + 1) != h.et_at(k))
+				{
+					continue;
+				}
+
+				//zero-length row: the burns this spacecraft made at this epoch (if any) are the whole difference
+				double dv = 0.0;
+				for (const Maneuver& burn : ledger)
+				{
+					dv += (burn.sc_index == i && burn.et == h.et_at(k)) ? burn.dv_rtn.norm() : 0.0;
+				}
+				const Eigen::Vector<double, 6> pre = h.cart_at(k);
+				const Eigen::Vector<double, 6> post = h.cart_at(k + 1);
+				CHECK(post.head<3>() == pre.head<3>());
+				if (dv == 0.0)
+				{
+					n_repeats++;
+					CHECK(post == pre);
+				}
+				else
+				{
+					CHECK((post.tail<3>() - pre.tail<3>()).norm() > 0.0);
+					CHECK((post.tail<3>() - pre.tail<3>()).norm() <= dv + 1e-12); //rounding in vel + dv is absolute, not relative to dv
+				}
+
+				//the next step carries on from the post-burn row
+				if (k + 2 < h.get_rows())
+				{
+					Eigen::Vector<double, 6> next = rk4.step(h.et_at(k + 1), h.et_at(k + 2) - h.et_at(k + 1), post);
+					CHECK_CLOSE((next.head<3>() - h.cart_at(k + 2).head<3>()).norm(), 0.0, step_tol);
+				}
+			}
+			CHECK(n_repeats > 0 || sats.size() == 1);
+		}
+	}
+
+	void run(Planet& earth, Integrator& rk4, PropagationMode mode, double step_tol)
+	{
+		WalkerDelta shell(earth, rk4, 0.0, 12, 3, 1, 53.0 * astrokit::DEG2RAD, astrokit::EARTH.R_EQUATOR_km + 550.0);
+		shell.set_sc_bounds(BoundingBox{ 0.01, 1e-5, 1e-5, 1e-4 }); //tight enough that everyone burns within a few orbits
+		PropagationOptions options;
+		options.mode = mode;
+		options.station_keeping = true;
+		shell.set_prop_options(options);
+		shell.propagate(4.0 * 5760.0, STEP);
+		check_histories(shell, rk4, step_tol);
+	}
+}
+
+int main()
+{
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+	ForceModel j2(earth, true);
+	Integrator rk4(earth, j2);
+
+	std::printf("per_spacecraft:\n");
+	run(earth, rk4, PropagationMode::per_spacecraft, 1e-9);
+	std::printf("batch:\n");
+	run(earth, rk4, PropagationMode::batch, 1e-6); //SIMD kernel; same step, different rounding
+
+	return test::finish("test_station_keeping_rows");
+}
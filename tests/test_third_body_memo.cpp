@@ -0,0 +1,73 @@
+/*
+Third-body position memo invalidation
+
+ThirdBodyTerm memoizes body positions per thread by (planet, body, epoch), which has to keep returning exactly what
+Planet::body_position returns even when the source of those positions changes between propagations. Each change is
+made with the memo already holding the same epochs, and every lookup afterwards is compared bit for bit:
+	- building the planet's ephemeris cache (SPICE -> Chebyshev fit)
+	- rebuilding it over a different span (different segments, so a different fit)
+	- reloading the SPICE kernels
+*/
+
+#include <cstdint>
+#include <vector>
+#include "ThirdBodyTerm.h"
+#include "Planet.h"
+#include <astrokit/constants.h>
+#include "test_utils.h"
+
+namespace
+{
+	constexpr int N_SAMPLES = 12; //2 bodies x 12 epochs fit in the memo, so every pass starts with all of them memoized
+	constexpr double SPAN = 86400.0 * 5.0; //[s]
+
+	//looks every sample epoch up through the memo & compares with a fresh lookup; returns how many positions differ
+	// from the previous pass (i.e. how many entries the memo must not have served from before the change)
+	std::size_t check_pass(const ThirdBodyTerm& term, const Planet& earth, std::vector<Eigen::Vector3d>& previous)
+	{
+		std::vector<Eigen::Vector3d> current;
+		for (int body : { 10, 301 })
+		{
+			for (int k = 0; k < N_SAMPLES; k++)
+			{
+				const double et = SPAN * static_cast<double>(k) / N_SAMPLES;
+				const Eigen::Vector3d fresh = earth.body_position(body, et);
+				CHECK(term.body_position(body, et) == fresh);
+				CHECK(term.body_position(body, et) == fresh); //second lookup is a memo hit
+				current.push_back(fresh);
+			}
+		}
+
+		std::size_t n_changed = 0;
+		for (std::size_t k = 0; k < previous.size() && k < current.size(); k++)
+		{
+			n_changed += (previous[k] != current[k]);
+		}
+		previous.swap(current);
+		return n_changed;
+	}
+}
+
+int main()
+{
+	SpiceHandler spice;
+	Planet earth(spice, astrokit::EARTH.MU_km3_s2, astrokit::EARTH.R_MEAN_km, astrokit::EARTH.R_EQUATOR_km, astrokit::EARTH.J2, 399, "IAU_EARTH");
+	std::vector<PerturbingBody> bodies{ { 10, astrokit::MU_SUN_km3_s2 }, { 301, 4902.8 } };
+	ThirdBodyTerm term(earth, bodies);
+	std::vector<Eigen::Vector3d> previous;
+
+	check_pass(term, earth, previous); //straight from SPICE
+
+	earth.cache_ephemeris(0.0, SPAN, { 10, 301 });
+	CHECK(check_pass(term, earth, previous) > 0); //the fit isn't bit-identical to SPICE, so the memo had to refresh
+
+	earth.cache_ephemeris(-0.37 * SPAN, 1.61 * SPAN, { 10, 301 });
+	CHECK(check_pass(term, earth, previous) > 0);
+
+	const std::uint64_t generation = SpiceHandler::ephemeris_generation();
+	spice.reload_kernels();
+	CHECK(SpiceHandler::ephemeris_generation() != generation);
+	check_pass(term, earth, previous);
+
+	return test::finish("test_third_body_memo");
+}
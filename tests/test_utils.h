@@ -0,0 +1,49 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+
+//bare-bones checks for the test executables (no test framework dependency); every failed check is printed and counted,
+// and main returns test::finish() so ctest sees a non-zero exit code
+namespace test
+{
+	inline int& failure_count()
+	{
+		static int failures = 0;
+		return failures;
+	}
+
+	inline bool check(bool ok, const char* expression, const char* file, int line)
+	{
+		if (!ok)
+		{
+			std::printf("%s:%d: check failed: %s\n", file, line, expression);
+			failure_count()++;
+		}
+		return ok;
+	}
+
+	inline bool check_close(double a, double b, double tol, const char* expression, const char* file, int line)
+	{
+		bool ok = std::abs(a - b) <= tol; //false for NaNs too
+		if (!ok)
+		{
+			std::printf("%s:%d: check failed: %s (%.17g vs %.17g, tol %.3g)\n", file, line, expression, a, b, tol);
+			failure_count()++;
+		}
+		return ok;
+	}
+
+	inline int finish(const char* test_name)
+	{
+		if (failure_count() == 0)
+		{
+			std::printf("%s: passed\n", test_name);
+			return 0;
+		}
+		std::printf("%s: %d check(s) failed\n", test_name, failure_count());
+		return 1;
+	}
+}
+
+#define CHECK(cond) test::check((cond), #cond, __FILE__, __LINE__)
+#define CHECK_CLOSE(a, b, tol) test::check_close((a), (b), (tol), #a " ~= " #b, __FILE__, __LINE__)